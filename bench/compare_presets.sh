@@ -0,0 +1,33 @@
+#!/bin/bash
+# Usage: bench/compare_presets.sh [PRESET...]
+# Builds waller_bench with every preset (all of them by default), runs it
+# and reports each case's speedup over the debug build. Results are kept in
+# build/<preset>/bench.json.
+set -e
+cd "$(dirname "$0")/.."
+
+presets=("$@")
+if [ ${#presets[@]} -eq 0 ]; then
+    presets=(release relwithdebinfo-lto native pgo)
+fi
+
+build() {
+    if [ "$1" = "pgo" ]; then
+        cmake --preset pgo-generate >/dev/null
+        cmake --build --preset pgo-generate >/dev/null
+        cmake --preset pgo-use >/dev/null
+        cmake --build --preset pgo-use >/dev/null
+    else
+        cmake --preset "$1" >/dev/null
+        cmake --build --preset "$1" >/dev/null
+    fi
+}
+
+build debug
+build/debug/waller_bench --json build/debug/bench.json >/dev/null
+
+for preset in "${presets[@]}"; do
+    build "$preset"
+    echo "== $preset (speedup over debug)"
+    "build/$preset/waller_bench" --baseline build/debug/bench.json --json "build/$preset/bench.json"
+done
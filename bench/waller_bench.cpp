@@ -0,0 +1,715 @@
+// Benchmarks for the robot GP simulator and engine.
+//
+// Self-contained harness: every case is timed for a number of repetitions,
+// each long enough to reach --min-time, and reports the median and the
+// fastest repetition per operation. Results print as a table and, with
+// --json FILE, as JSON in the layout of Google Benchmark's reporter so two
+// commits can be diffed with the usual tools. --baseline FILE adds the
+// speedup of every case over an earlier JSON result, which is how
+// bench/compare_presets.sh compares build presets.
+//
+// Cases cover the robot primitives (walkFront, align), Environment's path
+// checks, fitness per individual through every evaluator path, genome copy
+// and crossover for Tree and LinearTree, population archives, the engine's
+// breeding phases and a full generation. The evaluator paths are also
+// cross-checked: tree walk against bytecode, early termination against
+// full runs, sequential runs against the batched lanes and LinearTree
+// against Tree must all give identical fitness, the two genomes must
+// evolve identically from the same seed, and an archive must read back the
+// genomes written to it, or the exit code is 1.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "gp_archive.hpp"
+#include "gp_linear_tree.hpp"
+#include "robot_gp.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Program = gp::Tree<robot_gp::RobotNodeValue>;
+using LinearProgram = gp::LinearTree<robot_gp::RobotNodeValue>;
+
+constexpr std::uint64_t SCENARIO_SEED = 12345;
+constexpr int PROGRAMS = 200;
+constexpr int BATCH_RUNS = 8;
+
+struct Options {
+    std::string json;           // Output file, "-" for stdout; empty for none
+    std::string filter;         // Only cases whose name contains this
+    std::string baseline;       // Earlier --json output to report speedups against
+    int repetitions = 5;
+    double min_time = 0.05;     // Seconds per repetition
+};
+
+struct Result {
+    std::string name;
+    std::size_t iterations;     // Body calls per repetition
+    std::size_t ops;            // Operations per body call
+    double median_ns;           // Per operation
+    double min_ns;
+    std::vector<std::pair<std::string, double>> counters;
+
+    Result& counter(const std::string& key, double value) {
+        counters.emplace_back(key, value);
+        return *this;
+    }
+};
+
+class Harness {
+public:
+    explicit Harness(Options opts, std::map<std::string, double> baseline_ns = {})
+        : options(std::move(opts)), baseline(std::move(baseline_ns)) {}
+
+    [[nodiscard]] bool selected(const std::string& name) const {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    }
+
+    // Time body, which performs ops operations per call. The first call
+    // warms up and sizes the repetitions.
+    template<typename Body>
+    Result& run(const std::string& name, std::size_t ops, Body&& body) {
+        auto start = Clock::now();
+        body();
+        double once = std::chrono::duration<double>(Clock::now() - start).count();
+        std::size_t iterations = std::clamp<std::size_t>(
+            static_cast<std::size_t>(std::ceil(options.min_time / std::max(once, 1e-9))), 1, 1'000'000);
+
+        std::vector<double> samples;
+        for (int r = 0; r < options.repetitions; ++r) {
+            start = Clock::now();
+            for (std::size_t i = 0; i < iterations; ++i) {
+                body();
+            }
+            double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            samples.push_back(ns / static_cast<double>(iterations * ops));
+        }
+        std::sort(samples.begin(), samples.end());
+        const std::size_t mid = samples.size() / 2;
+        double median = samples.size() % 2 ? samples[mid] : (samples[mid - 1] + samples[mid]) / 2;
+
+        results.push_back({name, iterations, ops, median, samples.front(), {}});
+        if (auto it = baseline.find(name); it != baseline.end()) {
+            results.back().counter("speedup", it->second / median);
+        }
+        return results.back();
+    }
+
+    void check(const std::string& name, int mismatches) {
+        checks.emplace_back(name, mismatches);
+    }
+
+    [[nodiscard]] int mismatches() const {
+        int total = 0;
+        for (const auto& [name, count] : checks) total += count;
+        return total;
+    }
+
+    void print_table(std::ostream& out) const;
+    void write_json(std::ostream& out, const std::string& executable) const;
+
+private:
+    Options options;
+    std::map<std::string, double> baseline; // Median ns per case
+    std::vector<Result> results;
+    std::vector<std::pair<std::string, int>> checks;
+};
+
+// Nanoseconds with a unit that keeps three significant digits readable
+std::string format_time(double ns) {
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(3);
+    if (ns >= 1e6) s << ns / 1e6 << " ms";
+    else if (ns >= 1e3) s << ns / 1e3 << " us";
+    else s << ns << " ns";
+    return s.str();
+}
+
+void Harness::print_table(std::ostream& out) const {
+    out << std::left << std::setw(40) << "case" << std::right << std::setw(14) << "median/op"
+        << std::setw(14) << "min/op" << std::setw(12) << "iterations" << "\n"
+        << std::string(80, '-') << "\n";
+    for (const Result& r : results) {
+        out << std::left << std::setw(40) << r.name << std::right << std::setw(14) << format_time(r.median_ns)
+            << std::setw(14) << format_time(r.min_ns) << std::setw(12) << r.iterations;
+        for (const auto& [key, value] : r.counters) {
+            out << "  " << key << "=" << value;
+        }
+        out << "\n";
+    }
+    for (const auto& [name, count] : checks) {
+        out << "check " << name << ": " << count << " mismatches\n";
+    }
+}
+
+std::string quoted(const std::string& text) {
+    std::ostringstream s;
+    s << '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': s << "\\\""; break;
+            case '\\': s << "\\\\"; break;
+            case '\n': s << "\\n"; break;
+            case '\t': s << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    s << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+                } else {
+                    s << c;
+                }
+        }
+    }
+    s << '"';
+    return s.str();
+}
+
+std::string local_date() {
+    std::time_t now = std::time(nullptr);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+    return buffer;
+}
+
+std::string host_name() {
+    char buffer[256] = {};
+    if (gethostname(buffer, sizeof(buffer) - 1) != 0) return "";
+    return buffer;
+}
+
+void Harness::write_json(std::ostream& out, const std::string& executable) const {
+#ifdef NDEBUG
+    const char* build_type = "release";
+#else
+    const char* build_type = "debug";
+#endif
+#ifdef __OPTIMIZE__
+    const bool optimized = true;
+#else
+    const bool optimized = false;
+#endif
+
+    out << std::setprecision(10)
+        << "{\n  \"context\": {\n"
+        << "    \"date\": " << quoted(local_date()) << ",\n"
+        << "    \"host_name\": " << quoted(host_name()) << ",\n"
+        << "    \"executable\": " << quoted(executable) << ",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "    \"library_build_type\": " << quoted(build_type) << ",\n"
+        << "    \"optimized\": " << (optimized ? "true" : "false") << ",\n"
+        << "    \"compiler\": " << quoted(__VERSION__) << ",\n"
+        << "    \"batch_simd\": " << (robot_gp::batch_simd_supported() ? "true" : "false") << ",\n"
+        << "    \"repetitions\": " << options.repetitions << ",\n"
+        << "    \"min_time\": " << options.min_time << "\n"
+        << "  },\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << (i ? "," : "") << "\n    {\n"
+            << "      \"name\": " << quoted(r.name) << ",\n"
+            << "      \"run_name\": " << quoted(r.name) << ",\n"
+            << "      \"run_type\": \"aggregate\",\n"
+            << "      \"aggregate_name\": \"median\",\n"
+            << "      \"repetitions\": " << options.repetitions << ",\n"
+            << "      \"iterations\": " << r.iterations * r.ops << ",\n"
+            << "      \"real_time\": " << r.median_ns << ",\n"
+            << "      \"cpu_time\": " << r.median_ns << ",\n"
+            << "      \"min_time\": " << r.min_ns << ",\n"
+            << "      \"time_unit\": \"ns\"";
+        for (const auto& [key, value] : r.counters) {
+            out << ",\n      " << quoted(key) << ": " << value;
+        }
+        out << "\n    }";
+    }
+    out << "\n  ],\n  \"checks\": {";
+    for (std::size_t i = 0; i < checks.size(); ++i) {
+        out << (i ? "," : "") << "\n    " << quoted(checks[i].first) << ": " << checks[i].second;
+    }
+    out << "\n  }\n}\n";
+}
+
+// Median time per case from a file write_json produced. Reads just the
+// "name" and "real_time" fields, in order, rather than parsing general JSON.
+std::map<std::string, double> read_baseline(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot read baseline " + path);
+    }
+    std::map<std::string, double> times;
+    std::string line, name;
+    while (std::getline(in, line)) {
+        const auto colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        const std::string key = line.substr(0, colon);
+        const auto first = line.find('"', colon);
+        if (key.find("\"name\"") != std::string::npos && first != std::string::npos) {
+            name = line.substr(first + 1, line.rfind('"') - first - 1);
+        } else if (key.find("\"real_time\"") != std::string::npos && !name.empty()) {
+            times[name] = std::atof(line.c_str() + colon + 1);
+            name.clear();
+        }
+    }
+    return times;
+}
+
+// Cheap deterministic fitness so breeding dominates the generation time
+struct HashFitness {
+    template<typename Genome>
+    double operator()(const Genome& genome) const {
+        return static_cast<double>(genome.hash() % 1000);
+    }
+};
+
+int count_mismatches(const std::vector<double>& a, const std::vector<double>& b) {
+    int count = 0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        count += a[i] != b[i];
+    }
+    return count;
+}
+
+// Robot primitives on fresh placements of the scenario. A placement resets
+// only the cells the previous one touched, so it is cheap next to the steps.
+void bench_robot(Harness& bench) {
+    constexpr int PLACEMENTS = 16;
+    constexpr int STEPS = 256;
+    Environment env;
+    env.initialize();
+    Robot robot(env);
+    ball_data ball{};
+
+    if (bench.selected("robot/walk_front")) {
+        bench.run("robot/walk_front", PLACEMENTS * STEPS, [&] {
+            for (int p = 0; p < PLACEMENTS; ++p) {
+                placeRun(env, robot, ball, SCENARIO_SEED, p);
+                for (int s = 0; s < STEPS; ++s) {
+                    robot.walkFront();
+                }
+            }
+        });
+    }
+
+    // One turn between aligns so the heading actually has to change
+    if (bench.selected("robot/align")) {
+        bench.run("robot/align", PLACEMENTS * STEPS, [&] {
+            for (int p = 0; p < PLACEMENTS; ++p) {
+                placeRun(env, robot, ball, SCENARIO_SEED, p);
+                for (int s = 0; s < STEPS; ++s) {
+                    robot.turnLeft();
+                    robot.align(ball.lin, ball.col);
+                }
+            }
+        });
+    }
+}
+
+// Path checks from random free cells, over both overloads
+void bench_environment(Harness& bench) {
+    constexpr int QUERIES = 4096;
+    Environment env;
+    env.initialize();
+
+    struct Query { double lin, col; int heading; double angle; int steps; };
+    std::vector<Query> queries;
+    gp::Rng rng(gp::derive_seed(SCENARIO_SEED, gp::streams::RUN, 0));
+    while (queries.size() < QUERIES) {
+        double lin = rng.uniform(1, env.height() - 2);
+        double col = rng.uniform(1, env.width() - 2);
+        if (env.getCell((int)lin, (int)col)) continue;
+        int heading = ANGLE * rng.uniform(0, (360 / ANGLE) - 1);
+        double angle = rng.unit() * 360.0;
+        queries.push_back({lin, col, heading, angle, 1 + (int)rng.below(2)});
+    }
+
+    volatile std::size_t clear = 0; // Keeps the calls from being optimized away
+    if (bench.selected("environment/is_path_clear/heading")) {
+        bench.run("environment/is_path_clear/heading", QUERIES, [&] {
+            for (const Query& q : queries) {
+                clear = clear + env.isPathClear(q.lin, q.col, q.heading, q.steps);
+            }
+        });
+    }
+    if (bench.selected("environment/is_path_clear/angle")) {
+        bench.run("environment/is_path_clear/angle", QUERIES, [&] {
+            for (const Query& q : queries) {
+                clear = clear + env.isPathClear(q.lin, q.col, q.angle, q.steps);
+            }
+        });
+    }
+}
+
+// FitnessEvaluator::operator() per individual, plus the reference paths it
+// has to agree with
+void bench_fitness(Harness& bench, const std::vector<Program>& programs, const std::vector<LinearProgram>& linear) {
+    auto evaluate_all = [&](std::vector<double>& out, auto&& evaluate) {
+        return [&out, &programs, evaluate] {
+            for (int i = 0; i < PROGRAMS; ++i) {
+                out[i] = evaluate(programs[i]);
+            }
+        };
+    };
+
+    robot_gp::FitnessEvaluator evaluator;
+    robot_gp::FitnessEvaluator full;
+    full.set_early_termination(false);
+    std::vector<double> compiled(PROGRAMS), walked(PROGRAMS), unpruned(PROGRAMS), flat(PROGRAMS);
+    auto compile = evaluate_all(compiled, [&](const Program& p) { return evaluator(p, SCENARIO_SEED); });
+    auto walk = evaluate_all(walked, [&](const Program& p) { return evaluator.evaluate_tree_walk(p, SCENARIO_SEED); });
+    auto run_full = evaluate_all(unpruned, [&](const Program& p) { return full(p, SCENARIO_SEED); });
+    auto compile_linear = [&] {
+        for (int i = 0; i < PROGRAMS; ++i) {
+            flat[i] = evaluator(linear[i], SCENARIO_SEED);
+        }
+    };
+
+    if (bench.selected("fitness/")) {
+        compile();
+        walk();
+        run_full();
+        compile_linear();
+        bench.check("tree_walk_vs_bytecode", count_mismatches(walked, compiled));
+        bench.check("early_stop_vs_full", count_mismatches(unpruned, compiled));
+        bench.check("linear_tree_vs_tree", count_mismatches(flat, compiled));
+    }
+    if (bench.selected("fitness/bytecode")) bench.run("fitness/bytecode", PROGRAMS, compile);
+    if (bench.selected("fitness/bytecode_linear")) bench.run("fitness/bytecode_linear", PROGRAMS, compile_linear);
+    if (bench.selected("fitness/tree_walk")) bench.run("fitness/tree_walk", PROGRAMS, walk);
+    if (bench.selected("fitness/full_steps")) bench.run("fitness/full_steps", PROGRAMS, run_full);
+
+    // Several runs per scenario: one after another, as evaluators do by
+    // default, vs. batched lanes, per lane and with the AVX2 kernels
+    robot_gp::FitnessEvaluator sequential_runs(HEIGHT, WIDTH, BATCH_RUNS);
+    robot_gp::FitnessEvaluator scalar_lanes(HEIGHT, WIDTH, BATCH_RUNS, robot_gp::RunBatching::LANES, false);
+    robot_gp::FitnessEvaluator simd_lanes(HEIGHT, WIDTH, BATCH_RUNS, robot_gp::RunBatching::LANES, true);
+    std::vector<double> sequential(PROGRAMS), batched(PROGRAMS), vectorized(PROGRAMS);
+    auto one_by_one = evaluate_all(sequential, [&](const Program& p) { return sequential_runs(p, SCENARIO_SEED); });
+    auto lanes = evaluate_all(batched, [&](const Program& p) { return scalar_lanes(p, SCENARIO_SEED); });
+    auto simd = evaluate_all(vectorized, [&](const Program& p) { return simd_lanes(p, SCENARIO_SEED); });
+
+    const std::string runs = "fitness/runs" + std::to_string(BATCH_RUNS) + "/";
+    if (bench.selected(runs)) {
+        one_by_one();
+        lanes();
+        simd();
+        bench.check("runs_batched_vs_sequential", count_mismatches(batched, sequential));
+        bench.check("runs_simd_vs_sequential", count_mismatches(vectorized, sequential));
+    }
+    if (bench.selected(runs + "sequential")) bench.run(runs + "sequential", PROGRAMS, one_by_one);
+    if (bench.selected(runs + "batched")) bench.run(runs + "batched", PROGRAMS, lanes);
+    if (bench.selected(runs + "batched_simd")) bench.run(runs + "batched_simd", PROGRAMS, simd);
+}
+
+// Genome copies and the splicing constructor crossover uses, for the
+// pointer Tree and the flat LinearTree holding the same programs
+void bench_tree(Harness& bench, const std::vector<Program>& programs, const std::vector<LinearProgram>& linear) {
+    double nodes = 0.0;
+    for (const Program& p : programs) nodes += static_cast<double>(p.size());
+    nodes /= PROGRAMS;
+
+    if (bench.selected("tree/copy")) {
+        std::vector<Program> copies;
+        copies.reserve(PROGRAMS);
+        bench.run("tree/copy", PROGRAMS, [&] {
+            copies.clear();
+            for (const Program& p : programs) {
+                copies.push_back(p);
+            }
+        }).counter("nodes_per_tree", nodes);
+    }
+    if (bench.selected("tree/copy_linear")) {
+        std::vector<LinearProgram> copies;
+        copies.reserve(PROGRAMS);
+        bench.run("tree/copy_linear", PROGRAMS, [&] {
+            copies.clear();
+            for (const LinearProgram& p : linear) {
+                copies.push_back(p);
+            }
+        }).counter("nodes_per_tree", nodes);
+    }
+
+    // Fixed parent pairs and crossover points within the depth limit
+    struct Splice { std::size_t base, point, donor, donor_point; };
+    std::vector<Splice> splices;
+    gp::Rng rng(31);
+    while (splices.size() < PROGRAMS) {
+        std::size_t base = rng.below(PROGRAMS), donor = rng.below(PROGRAMS);
+        std::size_t point = rng.below(programs[base].size());
+        std::size_t donor_point = rng.below(programs[donor].size());
+        if (programs[base].depth_with_replacement(point, programs[donor].subtree_depth(donor_point)) <= 17) {
+            splices.push_back({base, point, donor, donor_point});
+        }
+    }
+    if (bench.selected("tree/crossover")) {
+        std::vector<Program> children;
+        children.reserve(PROGRAMS);
+        bench.run("tree/crossover", PROGRAMS, [&] {
+            children.clear();
+            for (const Splice& s : splices) {
+                children.emplace_back(programs[s.base], s.point, programs[s.donor], s.donor_point);
+            }
+        });
+    }
+    if (bench.selected("tree/crossover_linear")) {
+        std::vector<LinearProgram> children;
+        children.reserve(PROGRAMS);
+        bench.run("tree/crossover_linear", PROGRAMS, [&] {
+            children.clear();
+            for (const Splice& s : splices) {
+                children.emplace_back(linear[s.base], s.point, linear[s.donor], s.donor_point);
+            }
+        });
+    }
+}
+
+// Writing the programs to an archive and decoding them back, each with a
+// fitness and lineage of its own; what is read must match what was written
+void bench_archive(Harness& bench, const std::vector<Program>& programs) {
+    if (!bench.selected("archive/")) return;
+    const std::string path =
+        (std::filesystem::temp_directory_path() / ("waller_bench_" + std::to_string(::getpid()) + ".gpa")).string();
+
+    std::vector<Program> scored = programs;
+    std::vector<gp::ArchiveLineage> lineages;
+    for (std::size_t i = 0; i < scored.size(); ++i) {
+        scored[i].fitness = static_cast<double>(i) * 0.25 - 7.0;
+        lineages.push_back({SCENARIO_SEED + i, static_cast<std::uint32_t>(i / 7),
+                            static_cast<std::uint32_t>(i % 3), static_cast<std::uint32_t>(i)});
+    }
+    auto write = [&] {
+        gp::ArchiveWriter<robot_gp::RobotNodeValue> archive(path);
+        for (std::size_t i = 0; i < scored.size(); ++i) {
+            archive.add(scored[i], lineages[i]);
+        }
+        archive.finish();
+    };
+
+    // Node values have no operator==; their archive codes identify them
+    auto codes = [](const Program& program) {
+        std::vector<std::uint8_t> result;
+        for (const auto& value : program.prefix()) {
+            result.push_back(static_cast<std::uint8_t>(gp::value_codec<robot_gp::RobotNodeValue>::encode(value)));
+        }
+        return result;
+    };
+
+    write();
+    int mismatches = 0;
+    {
+        gp::ArchiveReader archive(path);
+        mismatches += static_cast<int>(std::max(archive.size(), scored.size()) - std::min(archive.size(), scored.size()));
+        for (std::size_t i = 0; i < std::min(archive.size(), scored.size()); ++i) {
+            const Program read = archive.genome<robot_gp::RobotNodeValue>(i);
+            const gp::ArchiveEntry& entry = archive.entries()[i];
+            mismatches += codes(read) != codes(scored[i]) || read.fitness != scored[i].fitness ||
+                          entry.run_seed != lineages[i].run_seed || entry.generation != lineages[i].generation ||
+                          entry.island != lineages[i].island || entry.rank != lineages[i].rank;
+        }
+    }
+    bench.check("archive_round_trip", mismatches);
+
+    if (bench.selected("archive/write")) bench.run("archive/write", PROGRAMS, write);
+    if (bench.selected("archive/read")) {
+        gp::ArchiveReader archive(path);
+        std::vector<Program> decoded;
+        decoded.reserve(PROGRAMS);
+        bench.run("archive/read", PROGRAMS, [&] {
+            decoded.clear();
+            for (std::size_t i = 0; i < archive.size(); ++i) {
+                decoded.push_back(archive.genome<robot_gp::RobotNodeValue>(i));
+            }
+        });
+    }
+    std::filesystem::remove(path);
+}
+
+// Breeding phases, isolated through the rates on an engine whose fitness is
+// a hash: selection alone copies tournament winners, and the crossover and
+// mutation cases add one operator on top. Each operation is one generation.
+struct BreedingPhase { const char* name; double crossover_rate; double mutation_rate; };
+
+template<template<typename> class Genome>
+void bench_breeding(Harness& bench, const BreedingPhase& phase) {
+    if (!bench.selected(phase.name)) return;
+    using HashEngine = gp::GPEngine<robot_gp::RobotNodeValue, HashFitness, Genome>;
+
+    gp::Rng rng(7);
+    robot_gp::TreeGenerator generator(rng);
+    typename HashEngine::Parameters params;
+    params.population_size = 500;
+    params.crossover_rate = phase.crossover_rate;
+    params.mutation_rate = phase.mutation_rate;
+    params.seed = 99;
+    HashEngine engine(params, HashFitness{});
+    engine.initialize_population([&] { return Genome<robot_gp::RobotNodeValue>(generator.generate_tree(6)); });
+
+    std::uint64_t allocations = 0;
+    std::size_t generations = 0;
+    bench.run(phase.name, 1, [&] {
+        allocations += engine.evolve_with_stats().allocations.pool_allocations;
+        ++generations;
+    }).counter("allocations_per_generation", static_cast<double>(allocations) / static_cast<double>(generations));
+}
+
+void bench_engine(Harness& bench) {
+    bench_breeding<gp::Tree>(bench, {"engine/selection", 0.0, 0.0});
+    bench_breeding<gp::Tree>(bench, {"engine/crossover", 1.0, 0.0});
+    bench_breeding<gp::Tree>(bench, {"engine/mutation", 0.0, 1.0});
+    bench_breeding<gp::Tree>(bench, {"engine/breeding", 0.9, 0.1});
+    bench_breeding<gp::LinearTree>(bench, {"engine/breeding_linear", 0.9, 0.1});
+}
+
+// The same seeded run with Tree and with LinearTree genomes must report
+// the same generations and end with the same population
+void check_linear_evolution(Harness& bench) {
+    if (!bench.selected("engine/")) return;
+    constexpr std::size_t GENERATIONS = 8;
+
+    auto make_params = [](auto params) {
+        params.population_size = 100;
+        params.crossover_rate = static_cast<double>(CROSSING) / POPULATION;
+        params.mutation_rate = 0.1;
+        params.cache_capacity = 400;
+        params.seed = 99;
+        return params;
+    };
+    using TreeEngine = gp::GPEngine<robot_gp::RobotNodeValue, robot_gp::FitnessEvaluator>;
+    using LinearEngine = gp::GPEngine<robot_gp::RobotNodeValue, robot_gp::FitnessEvaluator, gp::LinearTree>;
+    TreeEngine tree_engine(make_params(TreeEngine::Parameters{}), robot_gp::FitnessEvaluator{});
+    LinearEngine linear_engine(make_params(LinearEngine::Parameters{}), robot_gp::FitnessEvaluator{});
+
+    gp::Rng tree_rng(5), linear_rng(5);
+    robot_gp::TreeGenerator tree_generator(tree_rng), linear_generator(linear_rng);
+    tree_engine.initialize_population([&] { return tree_generator.generate_tree(6); });
+    linear_engine.initialize_population([&] { return linear_generator.generate_linear_tree(6); });
+
+    int mismatches = 0;
+    for (std::size_t gen = 0; gen < GENERATIONS; ++gen) {
+        const auto a = tree_engine.evolve_with_stats();
+        const auto b = linear_engine.evolve_with_stats();
+        mismatches += a.best_fitness != b.best_fitness || a.average_fitness != b.average_fitness;
+    }
+    for (std::size_t i = 0; i < 100; ++i) {
+        const auto& a = tree_engine.get_individual(i);
+        const auto& b = linear_engine.get_individual(i);
+        mismatches += a.hash() != b.hash() || a.fitness != b.fitness;
+    }
+    bench.check("linear_tree_vs_tree_evolution", mismatches);
+}
+
+// Generations of the real run configuration, on one thread and on all
+void bench_generation(Harness& bench) {
+    using RobotEngine = gp::GPEngine<robot_gp::RobotNodeValue, robot_gp::FitnessEvaluator>;
+    const std::size_t threads[] = {1, std::max(1u, std::thread::hardware_concurrency())};
+
+    for (std::size_t t = 0; t < std::size(threads); ++t) {
+        if (t > 0 && threads[t] == threads[0]) break;
+        const std::string name = "engine/generation/threads:" + std::to_string(threads[t]);
+        if (!bench.selected(name)) continue;
+
+        RobotEngine::Parameters params;
+        params.population_size = POPULATION;
+        params.crossover_rate = static_cast<double>(CROSSING) / POPULATION;
+        params.mutation_rate = 0.1;
+        params.cache_capacity = 4 * POPULATION;
+        params.num_threads = threads[t];
+        params.seed = 99;
+        RobotEngine engine(params, robot_gp::FitnessEvaluator{});
+        gp::Rng rng(gp::derive_seed(params.seed, gp::streams::TREE_GENERATOR));
+        robot_gp::TreeGenerator generator(rng);
+        engine.initialize_population([&] { return generator.generate_tree(params.max_depth); });
+
+        std::size_t simulated = 0, generations = 0;
+        bench.run(name, 1, [&] {
+            simulated += engine.evolve_with_stats().cache_misses;
+            ++generations;
+        }).counter("evaluations_per_generation", static_cast<double>(simulated) / static_cast<double>(generations));
+    }
+}
+
+void usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--json FILE|-] [--baseline FILE] [--filter TEXT]"
+              << " [--repetitions N] [--min-time SECONDS]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) {
+            options.json = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            options.baseline = argv[++i];
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--repetitions" && i + 1 < argc) {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.min_time = std::max(0.0, std::atof(argv[++i]));
+        } else {
+            usage(argv[0]);
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    gp::Rng rng(2024);
+    robot_gp::TreeGenerator generator(rng);
+    std::vector<Program> programs;
+    for (int i = 0; i < PROGRAMS; ++i) {
+        programs.push_back(generator.generate_tree(2 + i % 8));
+    }
+    const std::vector<LinearProgram> linear(programs.begin(), programs.end());
+
+    std::map<std::string, double> baseline;
+    if (!options.baseline.empty()) {
+        try {
+            baseline = read_baseline(options.baseline);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 2;
+        }
+    }
+
+    Harness bench(options, std::move(baseline));
+    bench_robot(bench);
+    bench_environment(bench);
+    bench_fitness(bench, programs, linear);
+    bench_tree(bench, programs, linear);
+    bench_archive(bench, programs);
+    bench_engine(bench);
+    check_linear_evolution(bench);
+    bench_generation(bench);
+
+    if (options.json != "-") {
+        bench.print_table(std::cout);
+    }
+    if (options.json == "-") {
+        bench.write_json(std::cout, argv[0]);
+    } else if (!options.json.empty()) {
+        std::ofstream out(options.json);
+        bench.write_json(out, argv[0]);
+        if (!out) {
+            std::cerr << "Cannot write " << options.json << "\n";
+            return 2;
+        }
+    }
+    return bench.mismatches() == 0 ? 0 : 1;
+}
@@ -1,7 +1,20 @@
 #!/bin/bash
+# Usage: ./build.sh [debug|release|relwithdebinfo-lto|native|profile|trace|pgo]
+# Builds with the CMake preset of that name (release by default) and copies
+# waller here. pgo builds an instrumented waller, trains it on a short
+# fixed-seed run and rebuilds with the profile.
+set -e
 
-mkdir -p build
-cd build
-cmake ..
-make
-cp waller ..
\ No newline at end of file
+preset=${1:-release}
+
+if [ "$preset" = "pgo" ]; then
+    cmake --preset pgo-generate
+    cmake --build --preset pgo-generate
+    cmake --preset pgo-use
+    cmake --build --preset pgo-use
+    cp build/pgo/waller .
+else
+    cmake --preset "$preset"
+    cmake --build --preset "$preset"
+    cp "build/$preset/waller" .
+fi
@@ -0,0 +1,126 @@
+#include "checkpoint.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "gp_serialize.hpp"
+
+namespace {
+
+constexpr char MAGIC[8] = {'W', 'A', 'L', 'L', 'E', 'R', 'C', 'K'};
+constexpr std::uint32_t VERSION = 2;
+
+std::uint64_t fnv1a(const std::uint8_t* data, std::size_t length) {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+[[noreturn]] void fail(const std::string& what, const std::string& path) {
+    throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+void putString(gp::ByteWriter& out, const std::string& text) {
+    out.put_varint(text.size());
+    out.put_bytes({reinterpret_cast<const std::uint8_t*>(text.data()), text.size()});
+}
+
+std::string getString(gp::ByteReader& in) {
+    auto bytes = in.get_bytes(in.get_varint());
+    return {bytes.begin(), bytes.end()};
+}
+
+// The file, then its directory entry, so the rename survives a power loss
+void writeDurably(const std::string& path, const std::vector<std::uint8_t>& bytes) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) fail("Cannot create", path);
+    std::size_t written = 0;
+    while (written < bytes.size()) {
+        ssize_t n = ::write(fd, bytes.data() + written, bytes.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            fail("Cannot write", path);
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    if (::fsync(fd) != 0) {
+        ::close(fd);
+        fail("Cannot sync", path);
+    }
+    if (::close(fd) != 0) fail("Cannot close", path);
+}
+
+void syncDirectory(const std::string& path) {
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    if (directory.empty()) directory = ".";
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return; // Best effort: the data itself is already on disk
+    ::fsync(fd);
+    ::close(fd);
+}
+
+} // namespace
+
+void saveCheckpoint(const std::string& path, const RunCheckpoint& checkpoint) {
+    gp::ByteWriter out;
+    out.put_bytes({reinterpret_cast<const std::uint8_t*>(MAGIC), sizeof(MAGIC)});
+    out.put_u32(VERSION);
+    out.put_u64(checkpoint.seed);
+    out.put_varint(static_cast<std::uint64_t>(checkpoint.runs));
+    out.put_u8(checkpoint.steadyState ? 1 : 0);
+    out.put_varint(checkpoint.generations);
+    out.put_varint(checkpoint.nextGeneration);
+    putString(out, checkpoint.dataFile);
+    out.put_u64(checkpoint.dataFileSize);
+    out.put_u64(checkpoint.profileFileSize);
+    out.put_varint(checkpoint.engine.size());
+    out.put_bytes(checkpoint.engine);
+    out.put_u64(fnv1a(out.bytes.data(), out.bytes.size()));
+
+    const std::string temporary = path + ".tmp";
+    writeDurably(temporary, out.bytes);
+    if (::rename(temporary.c_str(), path.c_str()) != 0) fail("Cannot rename over", path);
+    syncDirectory(path);
+}
+
+RunCheckpoint loadCheckpoint(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) fail("Cannot open", path);
+    std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (bytes.size() < sizeof(MAGIC) + 8 || std::memcmp(bytes.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a checkpoint: " + path);
+    }
+    const std::size_t body = bytes.size() - 8;
+    gp::ByteReader hash({bytes.data() + body, 8});
+    if (hash.get_u64() != fnv1a(bytes.data(), body)) {
+        throw std::runtime_error("Corrupt checkpoint (hash mismatch): " + path);
+    }
+
+    gp::ByteReader in({bytes.data() + sizeof(MAGIC), body - sizeof(MAGIC)});
+    if (std::uint32_t version = in.get_u32(); version != VERSION) {
+        throw std::runtime_error("Unsupported checkpoint version " + std::to_string(version) + ": " + path);
+    }
+    RunCheckpoint checkpoint;
+    checkpoint.seed = in.get_u64();
+    checkpoint.runs = static_cast<int>(in.get_varint());
+    checkpoint.steadyState = in.get_u8() != 0;
+    checkpoint.generations = in.get_varint();
+    checkpoint.nextGeneration = in.get_varint();
+    checkpoint.dataFile = getString(in);
+    checkpoint.dataFileSize = in.get_u64();
+    checkpoint.profileFileSize = in.get_u64();
+    auto engine = in.get_bytes(in.get_varint());
+    checkpoint.engine.assign(engine.begin(), engine.end());
+    return checkpoint;
+}
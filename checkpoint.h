@@ -0,0 +1,40 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "constants.h"
+
+// Run checkpoints.
+//
+// A checkpoint holds what a single-population run needs to continue after
+// a crash: the run settings, where its data file ended, and the engine
+// state (gp::write_engine_state). The file is replaced atomically, so a
+// crash while saving leaves the previous checkpoint intact.
+//
+// Layout: "WALLERCK", u32 version, the fields below in order (strings and
+// the engine state as a varint length and bytes), then a u64 FNV-1a hash
+// of everything before it.
+
+struct RunCheckpoint {
+    std::uint64_t seed = 0;
+    int runs = RUNS;                   // Runs per scenario in every fitness
+    bool steadyState = false;
+    std::size_t generations = 0;       // Generations the run was started for
+    std::size_t nextGeneration = 0;    // First generation not yet reported
+    std::string dataFile;              // Log the run writes to
+    std::uint64_t dataFileSize = 0;    // Its length after generation nextGeneration - 1
+    std::uint64_t profileFileSize = 0; // Same for its _profile.csv; 0 without one
+    std::vector<std::uint8_t> engine;  // Serialized GPEngine::State
+};
+
+// Write to PATH.tmp, flush it to disk and rename it over PATH; throws
+// std::runtime_error on failure
+void saveCheckpoint(const std::string& path, const RunCheckpoint& checkpoint);
+
+// Throws std::runtime_error if the file is missing, truncated or corrupt
+RunCheckpoint loadCheckpoint(const std::string& path);
+
+#endif // CHECKPOINT_H
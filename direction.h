@@ -0,0 +1,141 @@
+#ifndef DIRECTION_H
+#define DIRECTION_H
+
+#include <array>
+
+// Unit step vectors for every integer heading in degrees.
+//
+// Robot headings are integer degrees: turns move them by ANGLE and align()
+// truncates the angle to the ball, so all 360 values are reachable. Moving
+// one cell along heading h is (lin + dlin, col + dcol) with dlin = -sin(h)
+// and dcol = cos(h), matching the grid's lin-down orientation.
+//
+// Entries are the sine/cosine of the exact angle, built at compile time
+// in double-double arithmetic (about 106 significant bits), so rounding to
+// double gives the correctly rounded value on every target, including
+// those where long double is plain double. The previous
+// sin((M_PI * angle) / 180) form rounded the argument first, so each
+// component can differ from it by up to ~2 ulp (4.5e-16). After rounding
+// into positions near 100 that is at most one position ulp per step, so
+// over EXECUTE = 2000 steps a trajectory stays within ~2e-11 cells of the
+// libm one; it only diverges when a position falls that close to a cell
+// boundary and truncates to another cell.
+struct StepVector {
+    double dlin;
+    double dcol;
+};
+
+namespace direction_detail {
+
+// Unevaluated sum hi + lo with |lo| <= ulp(hi) / 2. Error-free transforms
+// below assume round-to-nearest double without contraction, which holds
+// for constant evaluation.
+struct DoubleDouble {
+    double hi;
+    double lo;
+};
+
+constexpr DoubleDouble quickTwoSum(double a, double b) { // |a| >= |b|
+    double s = a + b;
+    return {s, b - (s - a)};
+}
+
+constexpr DoubleDouble twoSum(double a, double b) {
+    double s = a + b;
+    double bb = s - a;
+    return {s, (a - (s - bb)) + (b - bb)};
+}
+
+constexpr DoubleDouble twoProd(double a, double b) {
+    auto split = [](double x) {
+        double t = 134217729.0 * x; // 2^27 + 1
+        double hi = t - (t - x);
+        return DoubleDouble{hi, x - hi};
+    };
+    double p = a * b;
+    DoubleDouble x = split(a), y = split(b);
+    return {p, ((x.hi * y.hi - p) + x.hi * y.lo + x.lo * y.hi) + x.lo * y.lo};
+}
+
+constexpr DoubleDouble operator+(DoubleDouble a, DoubleDouble b) {
+    DoubleDouble s = twoSum(a.hi, b.hi);
+    return quickTwoSum(s.hi, s.lo + a.lo + b.lo);
+}
+
+constexpr DoubleDouble operator-(DoubleDouble a) {
+    return {-a.hi, -a.lo};
+}
+
+constexpr DoubleDouble operator*(DoubleDouble a, DoubleDouble b) {
+    DoubleDouble p = twoProd(a.hi, b.hi);
+    return quickTwoSum(p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi));
+}
+
+constexpr DoubleDouble operator/(DoubleDouble a, double d) {
+    double q1 = a.hi / d;
+    DoubleDouble r = a + -twoProd(q1, d);
+    return quickTwoSum(q1, r.hi / d);
+}
+
+constexpr DoubleDouble PI = {3.141592653589793116, 1.2246467991473532e-16};
+
+// Taylor series, accurate to double-double precision for |x| <= pi/4
+constexpr DoubleDouble sinSeries(DoubleDouble x) {
+    DoubleDouble term = x, sum = x;
+    for (int n = 1; n < 20; n++) {
+        term = -(term * x * x / double((2 * n) * (2 * n + 1)));
+        sum = sum + term;
+    }
+    return sum;
+}
+
+constexpr DoubleDouble cosSeries(DoubleDouble x) {
+    DoubleDouble term = {1, 0}, sum = {1, 0};
+    for (int n = 1; n < 20; n++) {
+        term = -(term * x * x / double((2 * n - 1) * (2 * n)));
+        sum = sum + term;
+    }
+    return sum;
+}
+
+// sin/cos of an integer angle in [0, 90], reduced to [0, 45] so the series
+// stays accurate and exact angles (0, 30, 90...) come out exact
+constexpr void firstQuadrant(int deg, double& s, double& c) {
+    DoubleDouble x = PI * DoubleDouble{double(deg <= 45 ? deg : 90 - deg), 0} / 180;
+    DoubleDouble sinx = sinSeries(x), cosx = cosSeries(x);
+    s = (deg <= 45 ? sinx : cosx).hi;
+    c = (deg <= 45 ? cosx : sinx).hi;
+}
+
+constexpr std::array<StepVector, 360> buildTable() {
+    std::array<StepVector, 360> table{};
+    for (int deg = 0; deg < 360; deg++) {
+        double s = 0, c = 0;
+        firstQuadrant(deg % 90, s, c);
+        double sinv = 0, cosv = 0;
+        switch (deg / 90) {
+            case 0: sinv =  s; cosv =  c; break;
+            case 1: sinv =  c; cosv = -s; break;
+            case 2: sinv = -s; cosv = -c; break;
+            default: sinv = -c; cosv =  s; break;
+        }
+        table[deg] = {-sinv, cosv};
+    }
+    return table;
+}
+
+} // namespace direction_detail
+
+inline constexpr std::array<StepVector, 360> DIRECTIONS = direction_detail::buildTable();
+
+// Heading in [0, 360) for any integer angle in degrees
+constexpr int normalizeHeading(int deg) {
+    deg %= 360;
+    return deg < 0 ? deg + 360 : deg;
+}
+
+constexpr const StepVector& stepFor(int heading) {
+    return DIRECTIONS[normalizeHeading(heading)];
+}
+
+#endif // DIRECTION_H
@@ -1,56 +1,89 @@
 #include "environment.h"
+#include "direction.h"
+#include <algorithm>
 #include <cmath>
 
-void Environment::initialize() {
-    for (int lin = 0; lin < HEIGHT; lin++) {
-        for (int col = 0; col < WIDTH; col++) {
-            if (lin == 0 || lin == HEIGHT-1 || col == 0 || col == WIDTH-1) {
-                grid[lin][col] = 2; // Border
-            } else {
-                grid[lin][col] = 0; // Empty space
-            }
-        }
+Environment::Environment(int height, int width)
+    : rows(height)
+    , cols(width)
+    , cells((height * width + 31) / 32, 0)
+    , pristine(cells.size(), 0) {}
+
+int Environment::staticCell(int lin, int col) const {
+    if (lin == 0 || lin == rows-1 || col == 0 || col == cols-1) {
+        return 2; // Border
     }
-    
+
+    // Obstacle layout of the reference 200x200 map, scaled to the actual size
     const int OBSTACLE_SIZE = 16;
     const int OBSTACLE_POSITIONS[] = {25, 91, 160};
-    
+
+    bool inObstacleLine = false, inObstacleCol = false;
     for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            int lin = OBSTACLE_POSITIONS[i];
-            int col = OBSTACLE_POSITIONS[j];
-            
-            for (int y = lin; y < lin + OBSTACLE_SIZE; y++) {
-                for (int x = col; x < col + OBSTACLE_SIZE; x++) {
-                    grid[y][x] = 2;
-                }
-            }
+        int linStart = OBSTACLE_POSITIONS[i] * rows / 200;
+        int colStart = OBSTACLE_POSITIONS[i] * cols / 200;
+        int linSize = std::max(1, OBSTACLE_SIZE * rows / 200);
+        int colSize = std::max(1, OBSTACLE_SIZE * cols / 200);
+        inObstacleLine |= lin >= linStart && lin < linStart + linSize;
+        inObstacleCol |= col >= colStart && col < colStart + colSize;
+    }
+    return (inObstacleLine && inObstacleCol) ? 2 : 0; // Obstacle or empty space
+}
+
+void Environment::initialize() {
+    std::fill(cells.begin(), cells.end(), 0);
+    for (int lin = 0; lin < rows; lin++) {
+        for (int col = 0; col < cols; col++) {
+            int cell = lin * cols + col;
+            cells[cell >> 5] |= (std::uint64_t)staticCell(lin, col) << ((cell & 31) * 2);
         }
     }
+    pristine = cells;
+    dirty.clear();
+}
+
+void Environment::reset() {
+    for (int cell : dirty) {
+        cells[cell >> 5] = pristine[cell >> 5];
+    }
+    dirty.clear();
 }
 
 bool Environment::isPathClear(double startLin, double startCol, double angle, int steps) const {
     double testlin = startLin - (steps * sin((M_PI * angle) / 180));
     double testcol = startCol + (steps * cos((M_PI * angle) / 180));
 
-    if (testlin < 1 || testlin > HEIGHT-2 || testcol < 1 || testcol > WIDTH-2) 
+    if (testlin < 1 || testlin > rows-2 || testcol < 1 || testcol > cols-2) 
         return false;
 
-    if (grid[(int)testlin][(int)testcol])
+    if (load((int)testlin * cols + (int)testcol))
         return false;
 
     return true;
 }
 
-void Environment::setCell(int lin, int col, int value) {
-    if (lin >= 0 && lin < HEIGHT && col >= 0 && col < WIDTH) {
-        grid[lin][col] = value;
-    }
+bool Environment::isPathClear(double startLin, double startCol, int heading, int steps) const {
+    const StepVector& step = stepFor(heading);
+    double testlin = startLin + (steps * step.dlin);
+    double testcol = startCol + (steps * step.dcol);
+
+    if (testlin < 1 || testlin > rows-2 || testcol < 1 || testcol > cols-2) 
+        return false;
+
+    if (load((int)testlin * cols + (int)testcol))
+        return false;
+
+    return true;
 }
 
-int Environment::getCell(int lin, int col) const {
-    if (lin >= 0 && lin < HEIGHT && col >= 0 && col < WIDTH) {
-        return grid[lin][col];
+void Environment::setCell(int lin, int col, int value) {
+    if (lin >= 0 && lin < rows && col >= 0 && col < cols) {
+        int cell = lin * cols + col;
+        if (load(cell) != value) {
+            dirty.push_back(cell);
+            int shift = (cell & 31) * 2;
+            cells[cell >> 5] = (cells[cell >> 5] & ~((std::uint64_t)3 << shift))
+                             | ((std::uint64_t)(value & 3) << shift);
+        }
     }
-    return -1;
-}
\ No newline at end of file
+}
@@ -1,18 +1,50 @@
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
-#define HEIGHT 200
-#define WIDTH 200
+#include <cstdint>
+#include <vector>
 
+#include "constants.h"
+
+// Occupancy grid. Cells hold 0 (empty), 1 (robot or ball) or 2 (border or
+// obstacle), packed 2 bits per cell so a 200x200 map is 10 KB and a whole
+// simulation state stays in L1/L2.
 class Environment {
 private:
-    int grid[HEIGHT][WIDTH];
+    int rows;
+    int cols;
+    std::vector<std::uint64_t> cells;    // 32 cells per word
+    std::vector<std::uint64_t> pristine; // cells as built by initialize()
+    std::vector<int> dirty;              // Cells written since the last initialize()/reset(), as lin*cols+col
+
+    int staticCell(int lin, int col) const; // Pristine map: borders and obstacles
+
+    int load(int cell) const {
+        return (int)((cells[cell >> 5] >> ((cell & 31) * 2)) & 3);
+    }
 
 public:
-    void initialize();
+    explicit Environment(int height = HEIGHT, int width = WIDTH);
+
+    void initialize();  // Full rebuild of the map, O(height*width)
+    void reset();       // Undo every setCell since initialize()/reset(), O(changes)
     bool isPathClear(double startLin, double startCol, double angle, int steps) const;
+    bool isPathClear(double startLin, double startCol, int heading, int steps) const; // DIRECTIONS lookup
     void setCell(int lin, int col, int value);
-    int getCell(int lin, int col) const;
+
+    int getCell(int lin, int col) const {
+        if (lin >= 0 && lin < rows && col >= 0 && col < cols) {
+            return load(lin * cols + col);
+        }
+        return -1;
+    }
+
+    // Packed cells (cell lin*width+col is bits 2*(cell%32) of word cell/32),
+    // for vectorized lookups. Stable for the Environment's lifetime.
+    const std::uint64_t* words() const { return cells.data(); }
+
+    int height() const { return rows; }
+    int width() const { return cols; }
 };
 
-#endif // ENVIRONMENT_H
\ No newline at end of file
+#endif // ENVIRONMENT_H
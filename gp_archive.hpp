@@ -0,0 +1,241 @@
+#ifndef GP_ARCHIVE_HPP
+#define GP_ARCHIVE_HPP
+
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gp_serialize.hpp"
+
+// Population archives: any number of genomes in one file, written as a
+// stream and read in place through mmap.
+//
+// Layout, little-endian, sections 8-byte aligned:
+//   ArchiveHeader        64 bytes
+//   node codes           detail::put_codes of every genome, back to back
+//   ArchiveEntry[count]  the index, 40 bytes per genome
+// The header is written last, so a file whose writer never finished has
+// no magic and is rejected; ArchiveWriter also removes such a file.
+// Opening an archive checks the header alone; entries are used straight
+// from the mapping, and a genome's codes are decoded only when that
+// genome is asked for.
+
+namespace gp {
+
+static_assert(std::endian::native == std::endian::little, "Archives are read in place as little-endian");
+
+inline constexpr char ARCHIVE_MAGIC[8] = {'G', 'P', 'A', 'R', 'C', 'H', 'I', 'V'};
+inline constexpr std::uint32_t ARCHIVE_VERSION = 1;
+
+struct ArchiveHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t bits;         // value_codec<T>::BITS of the node codes
+    std::uint64_t count;        // Genomes, and entries in the index
+    std::uint64_t codes_offset; // From the start of the file
+    std::uint64_t codes_size;
+    std::uint64_t index_offset;
+    std::uint64_t reserved[2];
+};
+static_assert(sizeof(ArchiveHeader) == 64);
+
+// Where an archived individual came from. The engine does not track
+// parents, so lineage is the run, island and generation it was saved from.
+struct ArchiveLineage {
+    std::uint64_t run_seed{0};
+    std::uint32_t generation{0}; // Generations the run had evaluated
+    std::uint32_t island{0};     // 0 outside island runs
+    std::uint32_t rank{0};       // Fitness rank in its population, 0 for the best
+};
+
+struct ArchiveEntry {
+    std::uint64_t codes_offset; // From the start of the file
+    std::uint32_t nodes;
+    std::uint32_t generation;
+    double fitness;             // Carried by the genome when added; waller adds GPEngine::ranked_population()
+                                // individuals, all scored under the scenario of generation `generation`
+    std::uint64_t run_seed;
+    std::uint32_t island;
+    std::uint32_t rank;
+};
+static_assert(sizeof(ArchiveEntry) == 40);
+
+// Streams genomes to an archive; only the index is kept in memory.
+// Throws std::runtime_error on I/O failure.
+template<typename T>
+class ArchiveWriter {
+public:
+    explicit ArchiveWriter(const std::string& path) : path(path), file(path, std::ios::binary | std::ios::trunc) {
+        if (!file) throw std::runtime_error("Cannot create archive " + path);
+        const ArchiveHeader placeholder{};
+        put(&placeholder, sizeof(placeholder));
+    }
+
+    // An archive that was never finished, or whose finish() failed, is
+    // removed rather than completed: its genomes may be only part of the
+    // population
+    ~ArchiveWriter() {
+        if (!finished) {
+            file.close();
+            std::remove(path.c_str());
+        }
+    }
+
+    ArchiveWriter(const ArchiveWriter&) = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+    template<typename Genome>
+    void add(const Genome& genome, const ArchiveLineage& lineage) {
+        const std::vector<T> prefix = genome.prefix();
+        codes.bytes.clear();
+        detail::put_codes(codes, std::span<const T>(prefix));
+        index.push_back({position, static_cast<std::uint32_t>(prefix.size()), lineage.generation, genome.fitness,
+                         lineage.run_seed, lineage.island, lineage.rank});
+        put(codes.bytes.data(), codes.bytes.size());
+    }
+
+    [[nodiscard]] std::size_t size() const { return index.size(); }
+
+    // Write the index and the header
+    void finish() {
+        ArchiveHeader header{};
+        std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+        header.version = ARCHIVE_VERSION;
+        header.bits = value_codec<T>::BITS;
+        header.count = index.size();
+        header.codes_offset = sizeof(ArchiveHeader);
+        header.codes_size = position - header.codes_offset;
+
+        const std::uint64_t zeros = 0;
+        put(&zeros, (8 - position % 8) % 8);
+        header.index_offset = position;
+        put(index.data(), index.size() * sizeof(ArchiveEntry));
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.close();
+        if (!file) throw std::runtime_error("Cannot write archive " + path);
+        finished = true;
+    }
+
+private:
+    std::string path;
+    std::ofstream file;
+    std::uint64_t position{0};
+    ByteWriter codes; // Reused for every genome
+    std::vector<ArchiveEntry> index;
+    bool finished{false};
+
+    void put(const void* data, std::size_t size) {
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        position += size;
+    }
+};
+
+// Read-only mapping of an archive. Throws std::runtime_error if the file
+// cannot be mapped or its header or index do not fit it.
+class ArchiveReader {
+public:
+    explicit ArchiveReader(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("Cannot open archive " + path + ": " + std::strerror(errno));
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(ArchiveHeader))) {
+            ::close(fd);
+            throw std::runtime_error("Not an archive: " + path);
+        }
+        length = static_cast<std::size_t>(info.st_size);
+        void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) throw std::runtime_error("Cannot map archive " + path + ": " + std::strerror(errno));
+        base = static_cast<const std::uint8_t*>(mapping);
+
+        const ArchiveHeader& h = header();
+        const bool valid = std::memcmp(h.magic, ARCHIVE_MAGIC, sizeof(h.magic)) == 0 &&
+                           h.codes_offset <= length && h.codes_size <= length - h.codes_offset &&
+                           h.index_offset % alignof(ArchiveEntry) == 0 && h.index_offset <= length &&
+                           h.count <= (length - h.index_offset) / sizeof(ArchiveEntry);
+        if (!valid || h.version != ARCHIVE_VERSION) {
+            unmap();
+            throw std::runtime_error((valid ? "Unsupported archive version: " : "Not an archive: ") + path);
+        }
+    }
+
+    ~ArchiveReader() { unmap(); }
+
+    ArchiveReader(ArchiveReader&& other) noexcept
+        : base(std::exchange(other.base, nullptr)), length(std::exchange(other.length, 0)) {}
+
+    ArchiveReader& operator=(ArchiveReader&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            base = std::exchange(other.base, nullptr);
+            length = std::exchange(other.length, 0);
+        }
+        return *this;
+    }
+
+    ArchiveReader(const ArchiveReader&) = delete;
+    ArchiveReader& operator=(const ArchiveReader&) = delete;
+
+    [[nodiscard]] const ArchiveHeader& header() const {
+        return *reinterpret_cast<const ArchiveHeader*>(base);
+    }
+
+    [[nodiscard]] std::size_t size() const { return header().count; }
+
+    [[nodiscard]] std::span<const ArchiveEntry> entries() const {
+        return {reinterpret_cast<const ArchiveEntry*>(base + header().index_offset), size()};
+    }
+
+    // Packed node codes of genome i
+    [[nodiscard]] std::span<const std::uint8_t> codes(std::size_t i) const {
+        if (i >= size()) throw std::out_of_range("Archive entry index out of range");
+        const ArchiveHeader& h = header();
+        const ArchiveEntry& entry = entries()[i];
+        const std::uint64_t bytes = (static_cast<std::uint64_t>(entry.nodes) * h.bits + 7) / 8;
+        if (entry.codes_offset < h.codes_offset || entry.codes_offset - h.codes_offset > h.codes_size ||
+            bytes > h.codes_size - (entry.codes_offset - h.codes_offset)) {
+            throw std::runtime_error("Archive entry " + std::to_string(i) + " points outside the node codes");
+        }
+        return {base + entry.codes_offset, static_cast<std::size_t>(bytes)};
+    }
+
+    // Decode genome i, with its archived fitness
+    template<typename T, template<typename> class Genome = Tree>
+    [[nodiscard]] Genome<T> genome(std::size_t i) const {
+        if (header().bits != value_codec<T>::BITS) {
+            throw std::runtime_error("Archive node codes are not " + std::to_string(value_codec<T>::BITS) + "-bit");
+        }
+        ByteReader in(codes(i));
+        const std::vector<T> prefix = detail::get_codes<T>(in, entries()[i].nodes);
+        Genome<T> genome{std::span<const T>(prefix)};
+        genome.fitness = entries()[i].fitness;
+        return genome;
+    }
+
+private:
+    const std::uint8_t* base{nullptr};
+    std::size_t length{0};
+
+    void unmap() {
+        if (base) ::munmap(const_cast<std::uint8_t*>(base), length);
+        base = nullptr;
+    }
+};
+
+} // namespace gp
+
+#endif // GP_ARCHIVE_HPP
@@ -10,6 +10,23 @@
 #include <algorithm>
 #include <queue>
 #include <stack>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+#include <utility>
+#include <unordered_map>
+
+#include "gp_fitness_cache.hpp"
+#include "gp_node_pool.hpp"
+#include "gp_profile.hpp"
+#include "gp_trace.hpp"
+#include "gp_random.hpp"
 
 namespace gp {
 
@@ -40,6 +57,34 @@ struct is_crossable {
     static constexpr bool value = decltype(test<T>(nullptr))::value;
 };
 
+// Structural hashing: FNV-1a over the prefix sequence of std::hash<T> values.
+// Arity is implied by each value, so equal sequences mean equal trees.
+inline constexpr std::uint64_t STRUCTURAL_HASH_SEED = 0xcbf29ce484222325ULL;
+
+template<typename T>
+[[nodiscard]] std::uint64_t structural_hash_step(std::uint64_t hash, const T& value) {
+    hash ^= static_cast<std::uint64_t>(std::hash<T>{}(value));
+    return hash * 0x100000001b3ULL;
+}
+
+// True when the fitness function accepts a scenario seed next to the individual
+template<typename F, typename G>
+inline constexpr bool is_seeded_fitness_v =
+    std::is_invocable_r_v<double, F&, const G&, std::uint64_t>;
+
+// How GPEngine moves from one population to the next
+enum class EvolutionMode {
+    GENERATIONAL, // Breed a whole new population every generation
+    STEADY_STATE  // Offspring replace individuals in place as their evaluations finish
+};
+
+// Steady state: which individual an offspring replaces. The current best is
+// never replaced.
+enum class Replacement {
+    WORST,     // Least fit individual
+    TOURNAMENT // Least fit of tournament_size random individuals
+};
+
 // Node structure using type-safe value storage
 template<typename T>
 class Node {
@@ -53,8 +98,24 @@ public:
     };
 
     NodeValue value;
-    std::vector<NodePtr> children;
+    std::vector<NodePtr, PoolAllocator<NodePtr>> children;
     Node* parent{nullptr}; // Non-owning pointer to parent for easier tree manipulation
+
+    // Nodes come from a per-size free-list pool: copying and dropping whole
+    // generations of trees recycles blocks instead of calling malloc per node
+    static void* operator new(std::size_t size) {
+        if (size == sizeof(Node)) return BlockPool<sizeof(Node)>::allocate();
+        ++allocation_counters().system_allocations;
+        return ::operator new(size);
+    }
+
+    static void operator delete(void* pointer, std::size_t size) noexcept {
+        if (size == sizeof(Node)) {
+            BlockPool<sizeof(Node)>::deallocate(pointer);
+        } else {
+            ::operator delete(pointer);
+        }
+    }
     
     // Constructor for terminal nodes
     explicit Node(T val) 
@@ -128,6 +189,15 @@ public:
         return nodes;
     }
 
+    // Get number of nodes in the subtree (including this node)
+    [[nodiscard]] size_t size() const {
+        size_t count = 1;
+        for (const auto& child : children) {
+            count += child->size();
+        }
+        return count;
+    }
+
     // Get node depth
     [[nodiscard]] size_t depth() const {
         size_t max_child_depth = 0;
@@ -164,6 +234,28 @@ public:
     Tree() = default;
     explicit Tree(NodePtr r) : root(std::move(r)) {}
 
+    // Build from a prefix-order sequence; arity comes from T::children_count()
+    explicit Tree(std::span<const T> prefix) {
+        if (prefix.empty()) return;
+        std::stack<std::pair<NodeType*, size_t>> open; // node, children still missing
+        for (const auto& value : prefix) {
+            auto node = std::make_unique<NodeType>(value);
+            auto* raw = node.get();
+            if (open.empty()) {
+                root = std::move(node);
+            } else {
+                open.top().first->add_child(std::move(node));
+                --open.top().second;
+            }
+            if (value.children_count() > 0) {
+                open.emplace(raw, value.children_count());
+            }
+            while (!open.empty() && open.top().second == 0) {
+                open.pop();
+            }
+        }
+    }
+
     // Deep copy constructor
     Tree(const Tree& other) : fitness(other.fitness) {
         if (other.root) {
@@ -171,6 +263,15 @@ public:
         }
     }
 
+    // Copy of base with the subtree at index replaced by a copy of donor's
+    // subtree at donor_index. Builds an offspring directly, without first
+    // copying the subtree it drops. donor may be base.
+    Tree(const Tree& base, size_t index, const Tree& donor, size_t donor_index) : fitness(base.fitness) {
+        if (!base.root) return;
+        size_t position = 0;
+        root = copy_spliced(*base.root, position, index, *donor.node_at(donor_index));
+    }
+
     // Move constructor
     Tree(Tree&&) noexcept = default;
 
@@ -205,6 +306,138 @@ public:
         return 0;
     }
 
+    // Get number of nodes in the tree
+    [[nodiscard]] size_t size() const {
+        if (!root) return 0;
+        size_t count = 0;
+        std::stack<const NodeType*> pending;
+        pending.push(root.get());
+        while (!pending.empty()) {
+            auto current = pending.top();
+            pending.pop();
+            ++count;
+            for (const auto& child : current->children) {
+                pending.push(child.get());
+            }
+        }
+        return count;
+    }
+
+    // Index-based genome interface shared with LinearTree; indices are prefix order
+
+    [[nodiscard]] const NodeType* node_at(size_t index) const {
+        if (!root) return nullptr;
+        std::stack<const NodeType*> pending;
+        pending.push(root.get());
+        for (size_t i = 0; !pending.empty(); ++i) {
+            auto current = pending.top();
+            pending.pop();
+            if (i == index) return current;
+            for (auto it = current->children.rbegin(); it != current->children.rend(); ++it) {
+                pending.push(it->get());
+            }
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] NodeType* node_at(size_t index) {
+        return const_cast<NodeType*>(std::as_const(*this).node_at(index));
+    }
+
+    [[nodiscard]] const T& value_at(size_t index) const {
+        return node_at(index)->value.value;
+    }
+
+    void set_value(size_t index, T value) {
+        node_at(index)->value.value = std::move(value);
+    }
+
+    // Prefix index of the k-th child of the node at index
+    [[nodiscard]] size_t child_index(size_t index, size_t k) const {
+        const auto* node = node_at(index);
+        size_t child = index + 1;
+        for (size_t c = 0; c < k; ++c) {
+            child += node->children[c]->size();
+        }
+        return child;
+    }
+
+    [[nodiscard]] size_t subtree_depth(size_t index) const {
+        return node_at(index)->depth();
+    }
+
+    // Depth the tree would have if the subtree at index were replaced by one
+    // of depth replacement_depth; lets breeding reject an oversized offspring
+    // before building it
+    [[nodiscard]] size_t depth_with_replacement(size_t index, size_t replacement_depth) const {
+        const NodeType* node = node_at(index);
+        size_t depth = replacement_depth;
+        for (const NodeType* parent = node->parent; parent; node = parent, parent = parent->parent) {
+            size_t deepest = depth;
+            for (const auto& sibling : parent->children) {
+                if (sibling.get() != node) {
+                    deepest = std::max(deepest, sibling->depth());
+                }
+            }
+            depth = 1 + deepest;
+        }
+        return depth;
+    }
+
+    // Replace the subtree at index with a copy of donor's subtree at donor_index.
+    // donor may be *this.
+    void replace_subtree(size_t index, const Tree& donor, size_t donor_index) {
+        auto copy = std::make_unique<NodeType>(*donor.node_at(donor_index));
+        auto* target = node_at(index);
+        if (target == root.get()) {
+            root = std::move(copy);
+        } else {
+            target->replace_with(std::move(copy));
+        }
+    }
+
+    [[nodiscard]] std::uint64_t hash() const {
+        std::uint64_t h = STRUCTURAL_HASH_SEED;
+        if (!root) return h;
+        std::stack<const NodeType*> pending;
+        pending.push(root.get());
+        while (!pending.empty()) {
+            auto current = pending.top();
+            pending.pop();
+            h = structural_hash_step(h, current->value.value);
+            for (auto it = current->children.rbegin(); it != current->children.rend(); ++it) {
+                pending.push(it->get());
+            }
+        }
+        return h;
+    }
+
+    // Node values in prefix order
+    [[nodiscard]] std::vector<T> prefix() const {
+        std::vector<T> out;
+        if (!root) return out;
+        std::stack<const NodeType*> pending;
+        pending.push(root.get());
+        while (!pending.empty()) {
+            auto current = pending.top();
+            pending.pop();
+            out.push_back(current->value.value);
+            for (auto it = current->children.rbegin(); it != current->children.rend(); ++it) {
+                pending.push(it->get());
+            }
+        }
+        return out;
+    }
+
+    // Prefix notation using T::to_char (e.g. "3FLA" for PROGN3 F L A)
+    [[nodiscard]] std::string to_string() const {
+        std::string out;
+        for (const auto& value : prefix()) {
+            out.push_back(value.to_char());
+        }
+        return out;
+    }
+
     // Get all nodes in the tree
     [[nodiscard]] std::vector<NodeType*> get_all_nodes() {
         if (!root) return {};
@@ -212,7 +445,8 @@ public:
     }
 
     // Get random node
-    [[nodiscard]] NodeType* get_random_node(std::mt19937& rng) {
+    template<typename URBG>
+    [[nodiscard]] NodeType* get_random_node(URBG& rng) {
         auto nodes = get_all_nodes();
         if (nodes.empty()) return nullptr;
         
@@ -221,7 +455,8 @@ public:
     }
 
     // Get random function node
-    [[nodiscard]] NodeType* get_random_function_node(std::mt19937& rng) {
+    template<typename URBG>
+    [[nodiscard]] NodeType* get_random_function_node(URBG& rng) {
         auto nodes = get_all_nodes();
         std::vector<NodeType*> function_nodes;
         std::copy_if(nodes.begin(), nodes.end(), std::back_inserter(function_nodes),
@@ -234,7 +469,8 @@ public:
     }
 
     // Get random terminal node
-    [[nodiscard]] NodeType* get_random_terminal_node(std::mt19937& rng) {
+    template<typename URBG>
+    [[nodiscard]] NodeType* get_random_terminal_node(URBG& rng) {
         auto nodes = get_all_nodes();
         std::vector<NodeType*> terminal_nodes;
         std::copy_if(nodes.begin(), nodes.end(), std::back_inserter(terminal_nodes),
@@ -245,12 +481,36 @@ public:
         std::uniform_int_distribution<size_t> dist(0, terminal_nodes.size() - 1);
         return terminal_nodes[dist(rng)];
     }
+
+private:
+    // Prefix-order copy that substitutes replacement for the node at index;
+    // position counts the source nodes visited so far
+    static NodePtr copy_spliced(const NodeType& node, size_t& position, size_t index, const NodeType& replacement) {
+        if (position++ == index) {
+            return std::make_unique<NodeType>(replacement);
+        }
+        auto copy = std::make_unique<NodeType>(node.value.value);
+        copy->value = node.value;
+        copy->children.reserve(node.children.size());
+        for (const auto& child : node.children) {
+            copy->add_child(copy_spliced(*child, position, index, replacement));
+        }
+        return copy;
+    }
 };
 
-// Main GP Engine class
-template<typename T, typename FitnessFunction>
+// Main GP Engine class.
+// Genome is any representation exposing the prefix-indexed interface of
+// Tree (size, depth, value_at, set_value, child_index, subtree_depth,
+// depth_with_replacement, replace_subtree, a prefix-span constructor, a
+// splicing constructor (base, index, donor, donor_index) and a fitness member);
+// LinearTree in gp_linear_tree.hpp is the flat alternative.
+template<typename T, typename FitnessFunction, template<typename> class Genome = Tree>
 class GPEngine {
 public:
+    using ValueType = T;
+    using GenomeType = Genome<T>;
+
     struct Parameters {
         std::size_t population_size = 500;
         std::size_t generations = 50;
@@ -259,21 +519,142 @@ public:
         std::size_t tournament_size = 5;
         std::size_t max_depth = 17;
         std::size_t max_nodes = 100;
+        std::size_t num_threads = 1;    // Fitness evaluation threads, each with its own FitnessFunction copy
+        std::uint64_t seed = 0;         // Run seed all streams derive from; 0 draws one from std::random_device
+        std::size_t cache_capacity = 0; // Fitness cache entries (LRU); 0 disables the cache
+        std::size_t scenario_interval = 1; // Generations sharing one scenario seed
+        std::size_t elitism = 1;        // Best individuals copied unchanged into the next generation
+        EvolutionMode mode = EvolutionMode::GENERATIONAL;
+        Replacement replacement = Replacement::WORST; // Steady state only
+        std::size_t steady_state_window = 32; // Steady state: offspring in flight; results depend on it, not on num_threads
+    };
+
+    // Steady state: one slot of the in-flight offspring window
+    struct Offspring {
+        GenomeType genome;
+        std::uint64_t scenario_seed{0};
+        FitnessCache::Key key{};
+        bool cached{false};
+        bool done{false};
+    };
+
+    // Everything the rest of a run depends on, taken between generations
+    // (see save_state). num_threads is left out: results do not depend on it.
+    struct State {
+        Parameters params;
+        std::uint64_t seed{0};
+        std::uint64_t rng_state{0};
+        std::uint64_t scenario_seed{0};
+        std::size_t generation{0};
+        std::vector<GenomeType> population;
+        std::vector<std::pair<FitnessCache::Key, double>> cache; // Most recently used first
+        GenomeType best;
+        std::uint64_t best_scenario_seed{0};
+        bool streaming{false};                       // Steady state: initial population scored, window in use
+        std::vector<std::uint64_t> individual_seeds; // Steady state
+        std::size_t best_index{0};                   // Steady state
+        std::size_t offspring_produced{0};           // Steady state
+        std::vector<Offspring> window;               // Steady state: slots in ring order
     };
 
 private:
     Parameters params;
-    std::vector<Tree<T>> population;
+    std::vector<GenomeType> population;
     FitnessFunction fitness_function;
-    std::mt19937 rng;
+    std::vector<FitnessFunction> workers; // Per-thread sandboxes, copied from fitness_function
+    std::uint64_t seed;                   // Resolved run seed
+    Rng rng;                              // streams::ENGINE
+    std::uint64_t scenario_seed{0};       // Seed shared by every evaluation of the current generation
+    std::size_t generation{0};            // Generations evaluated so far
+    FitnessCache cache;
+    std::size_t cache_hits{0};            // Evaluations skipped in the last generation
+    std::size_t cache_misses{0};          // Evaluations simulated in the last generation
+    std::vector<std::pair<double, std::size_t>> ranking; // (fitness, index); the first max(elitism, 1) are ordered
+    GenomeType best;                      // Best of the last evaluated generation
+    std::uint64_t best_scenario_seed{0};  // Scenario best was scored under
+
+    // Steady-state evaluation pipeline. Offspring are numbered in production
+    // order and live in a ring of `window` slots until committed; workers
+    // evaluate submitted slots in any order, but offspring n is always
+    // committed just before offspring n + window is produced, so every
+    // selection sees the same population regardless of thread timing.
+    struct OffspringStream {
+        std::vector<Offspring> slots;
+        std::vector<FitnessFunction> evaluators; // One per thread; empty evaluates inline
+        std::deque<std::size_t> pending;         // Slots waiting for a worker
+        std::mutex mutex;
+        std::condition_variable work;
+        std::condition_variable finished;
+        bool stopping{false};
+        std::vector<std::thread> threads;
+
+        OffspringStream(std::size_t window, std::size_t num_threads, const FitnessFunction& f)
+            : slots(window), evaluators(num_threads > 1 ? num_threads : 0, f) {
+            for (auto& evaluator : evaluators) {
+                threads.emplace_back([this, &evaluator] {
+                    trace::name_thread("fitness worker");
+                    loop(evaluator);
+                });
+            }
+        }
+
+        ~OffspringStream() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            work.notify_all();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        void submit(std::size_t slot) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending.push_back(slot);
+            }
+            work.notify_one();
+        }
+
+        void wait(std::size_t slot) {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&] { return slots[slot].done; });
+        }
+
+        void loop(FitnessFunction& evaluator) {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                work.wait(lock, [this] { return stopping || !pending.empty(); });
+                if (stopping) return;
+                Offspring& slot = slots[pending.front()];
+                pending.pop_front();
+                lock.unlock();
+                {
+                    trace::Span span("evaluate", "fitness", "slot", static_cast<std::int64_t>(&slot - slots.data()));
+                    slot.genome.fitness = score(evaluator, slot.genome, slot.scenario_seed);
+                }
+                lock.lock();
+                slot.done = true;
+                finished.notify_all();
+            }
+        }
+    };
+
+    std::vector<std::uint64_t> individual_seeds; // Steady state: scenario each individual was scored under
+    std::size_t best_index{0};                   // Steady state: current best individual
+    std::size_t offspring_produced{0};           // Steady state: offspring numbered so far
+    std::unique_ptr<OffspringStream> stream;     // Last member: its threads stop before the rest is destroyed
 
 public:
     explicit GPEngine(Parameters p, FitnessFunction f)
         : params(std::move(p))
         , fitness_function(std::move(f))
-        , rng(std::random_device{}()) {}
+        , seed(params.seed ? params.seed : (static_cast<std::uint64_t>(std::random_device{}()) << 32 | std::random_device{}()))
+        , rng(derive_seed(seed, streams::ENGINE))
+        , cache(params.cache_capacity) {}
 
-    void initialize_population(std::function<Tree<T>()> tree_generator) {
+    void initialize_population(std::function<GenomeType()> tree_generator) {
         population.clear();
         population.reserve(params.population_size);
         
@@ -285,187 +666,613 @@ public:
     struct EvolutionStats {
         double best_fitness;
         double average_fitness;
+        std::size_t cache_hits;   // Individuals whose fitness came from the cache
+        std::size_t cache_misses; // Individuals that were simulated
+        AllocationCounters allocations; // Node allocator calls on this thread during the generation
     };
 
-    [[nodiscard]] const Tree<T>& get_individual(size_t index) const {
+    [[nodiscard]] const GenomeType& get_individual(size_t index) const {
         if (index >= population.size()) {
             throw std::out_of_range("Individual index out of range");
         }
         return population[index];
     }
 
+    // Evaluate, rank and breed one generation; stats describe the evaluated population.
+    // In steady-state mode one call produces population_size offspring instead,
+    // and stats describe the population after their replacements.
     [[nodiscard]] EvolutionStats evolve_with_stats() {
-        // Get initial stats
-        EvolutionStats initial_stats = calculate_stats();
+        trace::Span span("generation", "engine", "generation", static_cast<std::int64_t>(generation));
+        if (params.mode == EvolutionMode::STEADY_STATE) {
+            return evolve_steady_state();
+        }
 
-        evolve();
+        // Evaluate fitness for all individuals
+        const AllocationCounters before = allocation_counters();
+        {
+            profile::ScopedPhase phase(profile::Phase::EVALUATION);
+            evaluate_population();
+        }
+
+        // Rank (fitness, index) pairs; only the elite prefix is ordered and
+        // the genomes themselves stay where they are
+        EvolutionStats stats;
+        {
+            trace::Span span("rank", "engine");
+            profile::ScopedPhase phase(profile::Phase::RANKING);
+            rank_population();
+            if (!ranking.empty()) {
+                best = population[ranking.front().second];
+                best_scenario_seed = scenario_seed;
+            }
+            stats = calculate_stats();
+        }
+        breed();
 
-        // Return final stats
-        return calculate_stats();
+        stats.allocations = allocations_since(before);
+        return stats;
     }
 
     void evolve() {
         for (std::size_t gen = 0; gen < params.generations; ++gen) {
-            // Evaluate fitness for all individuals
-            for (auto& individual : population) {
-                individual.fitness = fitness_function(individual);
-            }
-
-            // Sort population by fitness
-            std::sort(population.begin(), population.end(),
-                     [](const auto& a, const auto& b) {
-                         return a.fitness > b.fitness;
-                     });
-
-            // Create new generation
-            std::vector<Tree<T>> new_population;
-            new_population.reserve(params.population_size);
-
-            // Elitism: Keep best individual
-            new_population.push_back(population.front());
-
-            // Fill rest of population with crossover and mutation
-            while (new_population.size() < params.population_size) {
-                // Tournament selection
-                auto parent1 = tournament_select();
-                auto parent2 = tournament_select();
-
-                // Crossover
-                if (std::uniform_real_distribution<>(0, 1)(rng) < params.crossover_rate) {
-                    auto [child1, child2] = crossover(parent1, parent2);
-                    if (child1.depth() <= params.max_depth && child2.depth() <= params.max_depth) {
-                        new_population.push_back(std::move(child1));
-                        if (new_population.size() < params.population_size) {
-                            new_population.push_back(std::move(child2));
-                        }
-                    } else {
-                        // If children exceed max depth, keep parents
-                        new_population.push_back(parent1);
-                        if (new_population.size() < params.population_size) {
-                            new_population.push_back(parent2);
-                        }
-                    }
-                } else {
-                    new_population.push_back(parent1);
-                    if (new_population.size() < params.population_size) {
-                        new_population.push_back(parent2);
-                    }
-                }
+            (void)evolve_with_stats();
+        }
+    }
+
+    // Best of the last evaluated generation; it survives breeding unchanged
+    [[nodiscard]] const GenomeType& get_best() const {
+        return best;
+    }
+
+    // Copies of up to count elites of the last generation, best first; these
+    // are the individuals an island sends to its neighbours. Generational
+    // mode only, and never more than Parameters::elitism.
+    [[nodiscard]] std::vector<GenomeType> emigrants(std::size_t count) const {
+        count = std::min({count, params.elitism, population.size()});
+        return std::vector<GenomeType>(population.begin(), population.begin() + count);
+    }
+
+    // Replace the newest offspring with arrivals from other islands; they
+    // are scored with the rest of the next generation. Elites are kept.
+    void immigrate(std::vector<GenomeType> arrivals) {
+        const std::size_t elites = std::min(params.elitism, population.size());
+        std::size_t slot = population.size();
+        for (auto& arrival : arrivals) {
+            if (slot == elites) break;
+            population[--slot] = std::move(arrival);
+        }
+    }
+
+    // Run seed every random stream was derived from
+    [[nodiscard]] std::uint64_t get_seed() const {
+        return seed;
+    }
+
+    // Seed every evaluation of the last evaluated generation was run with
+    [[nodiscard]] std::uint64_t get_scenario_seed() const {
+        return scenario_seed;
+    }
+
+    // Seed get_best() was scored under; in steady-state mode it can be an
+    // earlier generation's
+    [[nodiscard]] std::uint64_t get_best_scenario_seed() const {
+        return best_scenario_seed;
+    }
+
+    // Copy of the current population scored under the scenario the next
+    // generation would use, best first (ties in population order). After a
+    // generational evolve_with_stats() most individuals are bred but not
+    // yet scored, and in steady-state mode they were scored under different
+    // scenarios; this gives every one a comparable fitness, e.g. for saving
+    // a final population. The engine itself is left as it was: the cache,
+    // RNG and generation count are not touched, so later generations are
+    // unaffected.
+    [[nodiscard]] std::vector<GenomeType> ranked_population() {
+        const std::size_t interval = std::max<std::size_t>(params.scenario_interval, 1);
+        std::vector<GenomeType> scored = population;
+        std::vector<std::size_t> indices(scored.size());
+        for (std::size_t i = 0; i < indices.size(); ++i) {
+            indices[i] = i;
+        }
+        evaluate_indices(scored, indices, derive_seed(seed, streams::SCENARIO, generation / interval));
+        std::stable_sort(indices.begin(), indices.end(), [&](std::size_t a, std::size_t b) {
+            return scored[a].fitness > scored[b].fitness;
+        });
+        std::vector<GenomeType> ranked;
+        ranked.reserve(scored.size());
+        for (auto i : indices) {
+            ranked.push_back(std::move(scored[i]));
+        }
+        return ranked;
+    }
+
+    // Snapshot for a checkpoint, between evolve_with_stats() calls. In
+    // steady-state mode the offspring still in flight are waited for and
+    // kept, scored, in their slots, so nothing is evaluated twice.
+    [[nodiscard]] State save_state() {
+        State state;
+        state.params = params;
+        state.seed = seed;
+        state.rng_state = rng.state();
+        state.scenario_seed = scenario_seed;
+        state.generation = generation;
+        state.population = population;
+        cache.for_each([&](const FitnessCache::Key& key, double fitness) {
+            state.cache.emplace_back(key, fitness);
+        });
+        state.best = best;
+        state.best_scenario_seed = best_scenario_seed;
+        if (stream) {
+            const std::size_t window = stream->slots.size();
+            for (std::size_t n = offspring_produced - std::min(offspring_produced, window); n < offspring_produced; ++n) {
+                stream->wait(n % window);
             }
+            state.streaming = true;
+            state.individual_seeds = individual_seeds;
+            state.best_index = best_index;
+            state.offspring_produced = offspring_produced;
+            state.window = stream->slots;
+        }
+        return state;
+    }
 
-            // Apply mutation
-            for (auto& individual : new_population) {
-                if (std::uniform_real_distribution<>(0, 1)(rng) < params.mutation_rate) {
-                    mutate(individual);
+    // Continue from a save_state() snapshot. The next evolve_with_stats()
+    // gives exactly what it would have given in the engine that saved it,
+    // provided the fitness function is configured the same way.
+    void restore_state(State state) {
+        const std::size_t window = std::max<std::size_t>(state.params.steady_state_window, 1);
+        if (state.population.size() != state.params.population_size && !state.population.empty()) {
+            throw std::invalid_argument("State population does not match its population_size");
+        }
+        if (state.streaming) {
+            if (state.params.mode != EvolutionMode::STEADY_STATE || state.window.size() != window ||
+                state.individual_seeds.size() != state.population.size() || state.best_index >= state.population.size()) {
+                throw std::invalid_argument("State has an inconsistent steady-state window");
+            }
+            for (std::size_t n = state.offspring_produced - std::min(state.offspring_produced, window); n < state.offspring_produced; ++n) {
+                if (!state.window[n % window].done) throw std::invalid_argument("State has an unscored offspring in flight");
+            }
+        }
+
+        stream.reset();
+        const std::size_t num_threads = params.num_threads;
+        params = std::move(state.params);
+        params.num_threads = num_threads;
+        seed = state.seed;
+        rng.set_state(state.rng_state);
+        scenario_seed = state.scenario_seed;
+        generation = state.generation;
+        population = std::move(state.population);
+        cache = FitnessCache(params.cache_capacity);
+        for (auto it = state.cache.rbegin(); it != state.cache.rend(); ++it) {
+            cache.insert(it->first, it->second);
+        }
+        cache_hits = cache_misses = 0;
+        ranking.clear();
+        best = std::move(state.best);
+        best_scenario_seed = state.best_scenario_seed;
+        individual_seeds = std::move(state.individual_seeds);
+        best_index = state.best_index;
+        offspring_produced = state.offspring_produced;
+        if (state.streaming) {
+            stream = std::make_unique<OffspringStream>(window, params.num_threads, fitness_function);
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            stream->slots = std::move(state.window);
+        }
+    }
+
+private:
+    [[nodiscard]] EvolutionStats calculate_stats() const {
+        EvolutionStats stats{0.0, 0.0, cache_hits, cache_misses, {}};
+        if (population.empty()) return stats;
+
+        stats.best_fitness = ranking.front().first;
+        for (const auto& individual : population) {
+            stats.average_fitness += individual.fitness;
+        }
+        stats.average_fitness /= static_cast<double>(population.size());
+        return stats;
+    }
+
+    [[nodiscard]] static AllocationCounters allocations_since(const AllocationCounters& before) {
+        const AllocationCounters& after = allocation_counters();
+        return {
+            after.pool_allocations - before.pool_allocations,
+            after.pool_deallocations - before.pool_deallocations,
+            after.system_allocations - before.system_allocations
+        };
+    }
+
+    static double score(FitnessFunction& f, const GenomeType& individual, std::uint64_t seed) {
+        if constexpr (is_seeded_fitness_v<FitnessFunction, GenomeType>) {
+            return f(individual, seed);
+        } else {
+            return f(individual);
+        }
+    }
+
+    // Every individual of a generation sees the same scenario seed, so the
+    // result of an evaluation does not depend on which thread ran it.
+    // Genomes already scored under that seed (cached, or duplicated within
+    // the generation) are not simulated again.
+    void evaluate_population() {
+        const std::size_t interval = std::max<std::size_t>(params.scenario_interval, 1);
+        scenario_seed = derive_seed(seed, streams::SCENARIO, generation++ / interval);
+
+        std::vector<std::size_t> pending;
+        pending.reserve(population.size());
+        cache_hits = cache_misses = 0;
+
+        if (cache.capacity() == 0) {
+            for (std::size_t i = 0; i < population.size(); ++i) {
+                pending.push_back(i);
+            }
+            evaluate_indices(population, pending, scenario_seed);
+            cache_misses = pending.size();
+            return;
+        }
+
+        std::vector<FitnessCache::Key> keys(population.size());
+        std::unordered_map<FitnessCache::Key, std::size_t, FitnessCache::KeyHash> first_seen;
+        std::vector<std::pair<std::size_t, std::size_t>> duplicates; // (individual, identical pending one)
+        for (std::size_t i = 0; i < population.size(); ++i) {
+            keys[i] = {population[i].hash(), scenario_seed};
+            if (auto cached = cache.find(keys[i])) {
+                population[i].fitness = *cached;
+            } else if (auto [it, inserted] = first_seen.emplace(keys[i], i); inserted) {
+                pending.push_back(i);
+            } else {
+                duplicates.emplace_back(i, it->second);
+            }
+        }
+
+        evaluate_indices(population, pending, scenario_seed);
+
+        for (auto [i, source] : duplicates) {
+            population[i].fitness = population[source].fitness;
+        }
+        for (auto i : pending) {
+            cache.insert(keys[i], population[i].fitness);
+        }
+        cache_misses = pending.size();
+        cache_hits = population.size() - cache_misses;
+    }
+
+    void evaluate_indices(std::vector<GenomeType>& genomes, const std::vector<std::size_t>& indices, std::uint64_t scenario) {
+        const std::size_t threads = std::min(params.num_threads, indices.size());
+        if (threads <= 1) {
+            for (auto i : indices) {
+                trace::Span span("evaluate", "fitness", "individual", static_cast<std::int64_t>(i));
+                genomes[i].fitness = score(fitness_function, genomes[i], scenario);
+            }
+            return;
+        }
+
+        while (workers.size() < threads) {
+            workers.push_back(fitness_function);
+        }
+
+        std::atomic<std::size_t> next{0};
+        std::vector<std::thread> pool;
+        pool.reserve(threads);
+        for (std::size_t t = 0; t < threads; ++t) {
+            pool.emplace_back([&genomes, &next, &indices, scenario, &worker = workers[t]] {
+                trace::name_thread("fitness worker");
+                for (std::size_t n = next++; n < indices.size(); n = next++) {
+                    auto i = indices[n];
+                    trace::Span span("evaluate", "fitness", "individual", static_cast<std::int64_t>(i));
+                    genomes[i].fitness = score(worker, genomes[i], scenario);
                 }
+            });
+        }
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+
+    // One steady-state generation: produce population_size offspring, each
+    // committed window offspring later by replacing an individual in place.
+    // Evaluations stream through the worker threads with no barrier; the
+    // last window offspring are still in flight when this returns.
+    [[nodiscard]] EvolutionStats evolve_steady_state() {
+        const AllocationCounters before = allocation_counters();
+        if (population.empty()) return {0.0, 0.0, 0, 0, {}};
+
+        if (!stream) {
+            // The initial population is scored once, as a whole
+            {
+                profile::ScopedPhase phase(profile::Phase::EVALUATION);
+                evaluate_population();
+            }
+            individual_seeds.assign(population.size(), scenario_seed);
+            best_index = 0;
+            for (std::size_t i = 1; i < population.size(); ++i) {
+                if (population[i].fitness > population[best_index].fitness) best_index = i;
             }
+            stream = std::make_unique<OffspringStream>(
+                std::max<std::size_t>(params.steady_state_window, 1), params.num_threads, fitness_function);
+        } else {
+            const std::size_t interval = std::max<std::size_t>(params.scenario_interval, 1);
+            scenario_seed = derive_seed(seed, streams::SCENARIO, generation++ / interval);
+            cache_hits = cache_misses = 0;
+        }
 
-            population = std::move(new_population);
+        const std::size_t window = stream->slots.size();
+        for (std::size_t count = 0; count < population.size(); ++count) {
+            const std::size_t n = offspring_produced++;
+            if (n >= window) commit_offspring(n - window);
+            produce_offspring(n);
         }
+
+        EvolutionStats stats{population[best_index].fitness, 0.0, cache_hits, cache_misses, {}};
+        for (const auto& individual : population) {
+            stats.average_fitness += individual.fitness;
+        }
+        stats.average_fitness /= static_cast<double>(population.size());
+        best = population[best_index];
+        best_scenario_seed = individual_seeds[best_index];
+        count_bred_nodes();
+
+        stats.allocations = allocations_since(before);
+        return stats;
     }
 
-    [[nodiscard]] const Tree<T>& get_best() const {
-        return population.front();
+    // Build offspring n into its slot and start its evaluation
+    void produce_offspring(std::size_t n) {
+        trace::Span span("offspring", "breeding", "offspring", static_cast<std::int64_t>(n));
+        const std::size_t s = n % stream->slots.size();
+        auto& slot = stream->slots[s];
+
+        std::optional<profile::ScopedPhase> selection(std::in_place, profile::Phase::SELECTION);
+        const GenomeType& parent1 = population[tournament_select()];
+        const GenomeType& parent2 = population[tournament_select()];
+        bool crossed = false;
+        if (rng.unit() < params.crossover_rate && parent1.size() > 0 && parent2.size() > 0) {
+            selection.reset();
+            profile::ScopedPhase crossover(profile::Phase::CROSSOVER);
+            auto point1 = rng.below(parent1.size());
+            auto point2 = rng.below(parent2.size());
+            if (parent1.depth_with_replacement(point1, parent2.subtree_depth(point2)) <= params.max_depth) {
+                slot.genome = GenomeType(parent1, point1, parent2, point2);
+                crossed = true;
+            }
+        }
+        if (!crossed) {
+            if (!selection) selection.emplace(profile::Phase::SELECTION);
+            slot.genome = parent1;
+        }
+        selection.reset();
+        if (rng.unit() < params.mutation_rate) {
+            profile::ScopedPhase phase(profile::Phase::MUTATION);
+            mutate(slot.genome);
+        }
+
+        slot.scenario_seed = scenario_seed;
+        slot.done = false;
+        slot.cached = false;
+        if (cache.capacity() > 0) {
+            slot.key = {slot.genome.hash(), scenario_seed};
+            if (auto cached = cache.find(slot.key)) {
+                slot.genome.fitness = *cached;
+                slot.cached = slot.done = true;
+                ++cache_hits;
+                return;
+            }
+        }
+        ++cache_misses;
+
+        if (stream->threads.empty()) {
+            trace::Span evaluate("evaluate", "fitness", "slot", static_cast<std::int64_t>(s));
+            profile::ScopedPhase phase(profile::Phase::EVALUATION);
+            slot.genome.fitness = score(fitness_function, slot.genome, scenario_seed);
+            slot.done = true;
+        } else {
+            stream->submit(s);
+        }
     }
 
-private:
-    Tree<T> tournament_select() {
-        std::vector<std::size_t> tournament_indices(params.tournament_size);
-        std::uniform_int_distribution<std::size_t> dist(0, population.size() - 1);
-        
-        for (auto& idx : tournament_indices) {
-            idx = dist(rng);
+    // Wait for offspring n and move it over the replaced individual
+    void commit_offspring(std::size_t n) {
+        const std::size_t s = n % stream->slots.size();
+        auto& slot = stream->slots[s];
+        {
+            profile::ScopedPhase phase(profile::Phase::EVALUATION);
+            stream->wait(s);
+        }
+        if (!slot.cached && cache.capacity() > 0) {
+            cache.insert(slot.key, slot.genome.fitness);
+        }
+
+        const std::size_t victim = select_replacement();
+        population[victim] = std::move(slot.genome);
+        individual_seeds[victim] = slot.scenario_seed;
+        if (population[victim].fitness > population[best_index].fitness) {
+            best_index = victim;
         }
-        
-        auto best_idx = *std::max_element(tournament_indices.begin(), 
-                                        tournament_indices.end(),
-                                        [this](auto a, auto b) {
-                                            return population[a].fitness < population[b].fitness;
-                                        });
-        
-        return population[best_idx];
     }
 
-    std::pair<Tree<T>, Tree<T>> crossover(const Tree<T>& parent1, const Tree<T>& parent2) {
-        Tree<T> offspring1 = parent1;
-        Tree<T> offspring2 = parent2;
+    // Individual an offspring replaces; never the current best
+    std::size_t select_replacement() {
+        const std::size_t size = population.size();
+        if (size == 1) return 0;
+
+        std::size_t victim = size;
+        if (params.replacement == Replacement::TOURNAMENT) {
+            for (std::size_t i = 0; i < params.tournament_size; ++i) {
+                std::size_t idx = rng.below(size);
+                if (idx != best_index && (victim == size || population[idx].fitness < population[victim].fitness)) {
+                    victim = idx;
+                }
+            }
+            if (victim != size) return victim;
+        }
 
-        // Get random crossover points
-        auto* node1 = offspring1.get_random_node(rng);
-        auto* node2 = offspring2.get_random_node(rng);
+        for (std::size_t i = 0; i < size; ++i) {
+            if (i != best_index && (victim == size || population[i].fitness < population[victim].fitness)) {
+                victim = i;
+            }
+        }
+        return victim;
+    }
 
-        if (!node1 || !node2) return {offspring1, offspring2};
+    void breed() {
+        // Create new generation
+        std::vector<GenomeType> new_population;
+        new_population.reserve(params.population_size);
 
-        // Create deep copies of subtrees
-        auto subtree1 = std::make_unique<Node<T>>(*node1);
-        auto subtree2 = std::make_unique<Node<T>>(*node2);
+        // Elitism: keep the best individuals, in rank order
+        const std::size_t elites = std::min(params.elitism, ranking.size());
+        for (std::size_t i = 0; i < elites; ++i) {
+            profile::ScopedPhase phase(profile::Phase::SELECTION);
+            new_population.push_back(population[ranking[i].second]);
+        }
+
+        // Fill rest of population with crossover and mutation. Parents are
+        // referenced in place; only genomes that enter new_population are built.
+        std::optional<trace::Span> crossover_batch(std::in_place, "selection+crossover", "breeding");
+        while (new_population.size() < params.population_size) {
+            std::optional<profile::ScopedPhase> selection(std::in_place, profile::Phase::SELECTION);
+
+            // Tournament selection
+            const GenomeType& parent1 = population[tournament_select()];
+            const GenomeType& parent2 = population[tournament_select()];
+
+            // Crossover; if either child would exceed max depth the parents are kept
+            if (rng.unit() < params.crossover_rate && parent1.size() > 0 && parent2.size() > 0) {
+                selection.reset();
+                profile::ScopedPhase crossover(profile::Phase::CROSSOVER);
+                auto point1 = rng.below(parent1.size());
+                auto point2 = rng.below(parent2.size());
+                if (parent1.depth_with_replacement(point1, parent2.subtree_depth(point2)) <= params.max_depth &&
+                    parent2.depth_with_replacement(point2, parent1.subtree_depth(point1)) <= params.max_depth) {
+                    new_population.emplace_back(parent1, point1, parent2, point2);
+                    if (new_population.size() < params.population_size) {
+                        new_population.emplace_back(parent2, point2, parent1, point1);
+                    }
+                    continue;
+                }
+            }
+
+            if (!selection) selection.emplace(profile::Phase::SELECTION);
+            new_population.push_back(parent1);
+            if (new_population.size() < params.population_size) {
+                new_population.push_back(parent2);
+            }
+        }
+
+        crossover_batch.reset();
+
+        // Apply mutation; elites are kept as evaluated
+        {
+            trace::Span span("mutation", "breeding");
+            profile::ScopedPhase phase(profile::Phase::MUTATION);
+            for (std::size_t i = elites; i < new_population.size(); ++i) {
+                if (rng.unit() < params.mutation_rate) {
+                    mutate(new_population[i]);
+                }
+            }
+        }
 
-        // Perform the swap
-        node1->replace_with(std::move(subtree2));
-        node2->replace_with(std::move(subtree1));
+        population = std::move(new_population);
+        count_bred_nodes();
+    }
 
-        return {std::move(offspring1), std::move(offspring2)};
+    void count_bred_nodes() const {
+        if constexpr (profile::ENABLED) {
+            std::size_t nodes = 0;
+            for (const auto& individual : population) nodes += individual.size();
+            profile::count(profile::Counter::NODES_BRED, nodes);
+        }
+    }
+
+    // Order the first max(elitism, 1) entries of ranking by fitness, ties by
+    // index so the result does not depend on the sort implementation.
+    // O(n log k) instead of sorting the whole population.
+    void rank_population() {
+        ranking.resize(population.size());
+        for (std::size_t i = 0; i < population.size(); ++i) {
+            ranking[i] = {population[i].fitness, i};
+        }
+        auto fitter = [](const auto& a, const auto& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        };
+        const std::size_t top = std::min(std::max<std::size_t>(params.elitism, 1), ranking.size());
+        if (top == 1) {
+            auto it = std::min_element(ranking.begin(), ranking.end(), fitter);
+            if (it != ranking.end()) std::iter_swap(ranking.begin(), it);
+        } else {
+            std::partial_sort(ranking.begin(), ranking.begin() + top, ranking.end(), fitter);
+        }
     }
 
-    // Generate a random subtree using the terminal and function set
-    NodePtr generate_random_subtree(size_t max_depth, 
-                                  const std::function<T()>& random_terminal,
-                                  const std::function<T()>& random_function) {
+    // Index of the fittest of tournament_size uniformly drawn individuals
+    std::size_t tournament_select() {
+        std::size_t best_idx = rng.below(population.size());
+        for (std::size_t i = 1; i < params.tournament_size; ++i) {
+            std::size_t idx = rng.below(population.size());
+            if (population[best_idx].fitness < population[idx].fitness) {
+                best_idx = idx;
+            }
+        }
+        return best_idx;
+    }
+
+    // Generate a random subtree in prefix order using the terminal and function set
+    void generate_random_subtree(std::vector<T>& prefix,
+                                 size_t max_depth,
+                                 const std::function<T()>& random_terminal,
+                                 const std::function<T()>& random_function) {
         if (max_depth <= 1) {
-            return std::make_unique<NodeType>(random_terminal());
+            prefix.push_back(random_terminal());
+            return;
         }
 
-        std::uniform_int_distribution<int> dist(0, 1);
-        if (dist(rng) == 0) {
-            return std::make_unique<NodeType>(random_terminal());
+        if (rng.below(2) == 0) {
+            prefix.push_back(random_terminal());
+            return;
         }
 
-        auto node = std::make_unique<NodeType>(random_function());
-        size_t num_children = node->value.children_count();
+        prefix.push_back(random_function());
+        size_t num_children = prefix.back().children_count();
 
         for (size_t i = 0; i < num_children; ++i) {
-            node->add_child(generate_random_subtree(max_depth - 1, random_terminal, random_function));
+            generate_random_subtree(prefix, max_depth - 1, random_terminal, random_function);
         }
-
-        return node;
     }
 
-    void mutate(Tree<T>& individual, 
+    void mutate(GenomeType& individual, 
                 const std::function<T()>& random_terminal = nullptr,
                 const std::function<T()>& random_function = nullptr,
                 const std::function<T()>& point_mutate = nullptr) {
-        auto* node = individual.get_random_node(rng);
-        if (!node) return;
+        if (individual.size() == 0) return;
+        auto point = rng.below(individual.size());
 
         // Different mutation types
-        std::uniform_int_distribution<int> mut_type(0, 2);
-        switch (mut_type(rng)) {
-            case 0: // Point mutation: change node's value
+        switch (rng.below(3)) {
+            case 0: // Point mutation: change node's value, keeping its arity
                 if (point_mutate) {
-                    node->value = NodeType::NodeValue{point_mutate()};
+                    T value = point_mutate();
+                    if (value.children_count() == individual.value_at(point).children_count()) {
+                        individual.set_value(point, std::move(value));
+                    }
                 }
                 break;
 
             case 1: // Subtree mutation: replace with new random subtree
                 if (random_terminal && random_function) {
-                    size_t remaining_depth = params.max_depth - node->depth();
+                    size_t remaining_depth = params.max_depth - individual.subtree_depth(point);
                     if (remaining_depth > 0) {
-                        auto new_subtree = generate_random_subtree(
-                            remaining_depth,
-                            random_terminal,
-                            random_function
-                        );
-                        node->replace_with(std::move(new_subtree));
+                        std::vector<T> prefix;
+                        generate_random_subtree(prefix, remaining_depth, random_terminal, random_function);
+                        individual.replace_subtree(point, GenomeType(std::span<const T>(prefix)), 0);
                     }
                 }
                 break;
 
             case 2: // Shrink mutation: replace function node with one of its children
-                if (node->value.is_function && !node->children.empty()) {
-                    std::uniform_int_distribution<size_t> child_dist(0, node->children.size() - 1);
-                    auto child_idx = child_dist(rng);
-                    auto child = std::make_unique<Node<T>>(*node->children[child_idx]);
-                    node->replace_with(std::move(child));
+                if (size_t arity = individual.value_at(point).children_count(); arity > 0) {
+                    auto child_idx = individual.child_index(point, rng.below(arity));
+                    individual.replace_subtree(point, individual, child_idx);
                 }
                 break;
         }
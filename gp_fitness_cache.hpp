@@ -0,0 +1,79 @@
+#ifndef GP_FITNESS_CACHE_HPP
+#define GP_FITNESS_CACHE_HPP
+
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace gp {
+
+// Bounded LRU map from (structural genome hash, scenario seed) to fitness.
+// Evaluation is deterministic for a given genome and seed, so a hit returns
+// exactly what simulating again would. Keys rely on the 64-bit structural
+// hash; a collision would return another genome's fitness.
+class FitnessCache {
+public:
+    struct Key {
+        std::uint64_t genome_hash;
+        std::uint64_t scenario_seed;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return static_cast<size_t>(key.genome_hash ^ (key.scenario_seed * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+
+    explicit FitnessCache(size_t capacity = 0) : max_entries(capacity) {}
+
+    // Lookup; a hit becomes the most recently used entry
+    [[nodiscard]] std::optional<double> find(const Key& key) {
+        auto it = index.find(key);
+        if (it == index.end()) return std::nullopt;
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->second;
+    }
+
+    void insert(const Key& key, double fitness) {
+        if (max_entries == 0) return;
+        if (auto it = index.find(key); it != index.end()) {
+            it->second->second = fitness;
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+        if (entries.size() == max_entries) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        entries.emplace_front(key, fitness);
+        index.emplace(key, entries.begin());
+    }
+
+    [[nodiscard]] size_t capacity() const { return max_entries; }
+    [[nodiscard]] size_t size() const { return entries.size(); }
+
+    // Visit (key, fitness) pairs, most recently used first; inserting them
+    // in reverse order into an empty cache rebuilds the same LRU order
+    template<typename Visitor>
+    void for_each(Visitor&& visit) const {
+        for (const auto& [key, fitness] : entries) visit(key, fitness);
+    }
+
+    void clear() {
+        entries.clear();
+        index.clear();
+    }
+
+private:
+    size_t max_entries;
+    std::list<std::pair<Key, double>> entries; // Most recently used first
+    std::unordered_map<Key, std::list<std::pair<Key, double>>::iterator, KeyHash> index;
+};
+
+} // namespace gp
+
+#endif // GP_FITNESS_CACHE_HPP
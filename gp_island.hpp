@@ -0,0 +1,292 @@
+#ifndef GP_ISLAND_HPP
+#define GP_ISLAND_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gp_engine.hpp"
+#include "gp_random.hpp"
+
+namespace gp {
+
+// Bounded single-producer single-consumer ring. Neither side takes a lock;
+// a side that has to wait (full on push, empty on pop) sleeps in
+// std::atomic::wait until the other side moves its index.
+template<typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(std::size_t capacity) : slots(capacity + 1) {}
+
+    void push(T value) {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        const std::size_t next = (t + 1) % slots.size();
+        for (std::size_t h = head.load(std::memory_order_acquire); h == next; h = head.load(std::memory_order_acquire)) {
+            head.wait(h, std::memory_order_acquire);
+        }
+        slots[t] = std::move(value);
+        tail.store(next, std::memory_order_release);
+        tail.notify_one();
+    }
+
+    [[nodiscard]] T pop() {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        for (std::size_t t = tail.load(std::memory_order_acquire); t == h; t = tail.load(std::memory_order_acquire)) {
+            tail.wait(t, std::memory_order_acquire);
+        }
+        T value = std::move(slots[h]);
+        head.store((h + 1) % slots.size(), std::memory_order_release);
+        head.notify_one();
+        return value;
+    }
+
+private:
+    std::vector<T> slots;
+    alignas(64) std::atomic<std::size_t> head{0}; // Next slot to pop; written by the consumer
+    alignas(64) std::atomic<std::size_t> tail{0}; // Next slot to push; written by the producer
+};
+
+// Which islands an island sends its emigrants to
+enum class MigrationTopology {
+    RING,      // Island i sends to island i + 1
+    ALL_TO_ALL // Every island sends to every other island
+};
+
+// Migration schedule and topology, shared by IslandModel and the
+// multi-process cluster so both exchange the same batches in the same order
+
+// Islands exchange emigrants after generation gen (0-based) of a run
+[[nodiscard]] inline bool migrates_after(std::size_t gen, std::size_t generations, std::size_t islands, std::size_t interval) {
+    return islands > 1 && interval > 0 && (gen + 1) % interval == 0 && gen + 1 < generations;
+}
+
+// Islands that island sends to, in island order
+[[nodiscard]] inline std::vector<std::size_t> migration_destinations(std::size_t island, std::size_t islands, MigrationTopology topology) {
+    if (topology == MigrationTopology::RING) return {(island + 1) % islands};
+    std::vector<std::size_t> out;
+    for (std::size_t to = 0; to < islands; ++to) {
+        if (to != island) out.push_back(to);
+    }
+    return out;
+}
+
+// Islands that island receives from, in island order; arrivals are
+// immigrated in this order
+[[nodiscard]] inline std::vector<std::size_t> migration_sources(std::size_t island, std::size_t islands, MigrationTopology topology) {
+    if (topology == MigrationTopology::RING) return {(island + islands - 1) % islands};
+    std::vector<std::size_t> out;
+    for (std::size_t from = 0; from < islands; ++from) {
+        if (from != island) out.push_back(from);
+    }
+    return out;
+}
+
+// One generation's stats over islands 0..islands-1, where stats_of(i) gives
+// island i's: best fitness over islands (the lowest island wins ties), mean
+// of the island averages, summed counters. Returns them with the best island.
+template<typename StatsOf>
+[[nodiscard]] auto aggregate_island_stats(std::size_t islands, StatsOf stats_of) {
+    auto total = stats_of(0);
+    std::size_t best_island = 0;
+    for (std::size_t i = 1; i < islands; ++i) {
+        const auto& stats = stats_of(i);
+        if (stats.best_fitness > total.best_fitness) {
+            total.best_fitness = stats.best_fitness;
+            best_island = i;
+        }
+        total.average_fitness += stats.average_fitness;
+        total.cache_hits += stats.cache_hits;
+        total.cache_misses += stats.cache_misses;
+        total.allocations.pool_allocations += stats.allocations.pool_allocations;
+        total.allocations.pool_deallocations += stats.allocations.pool_deallocations;
+        total.allocations.system_allocations += stats.allocations.system_allocations;
+    }
+    total.average_fitness /= static_cast<double>(islands);
+    return std::pair{total, best_island};
+}
+
+// Island model: N generational GPEngines, each on its own thread with its
+// own fitness function copy, exchanging elites every migration_interval
+// generations.
+//
+// There is no global barrier. At a migration generation an island pushes
+// its emigrants into one SPSC queue per destination, then pops exactly one
+// batch from each source in island order. It only ever waits for its own
+// sources to reach the same generation, and the result is deterministic for
+// a given seed whatever the thread timing.
+template<typename T, typename FitnessFunction, template<typename> class Genome = Tree>
+class IslandModel {
+public:
+    using Engine = GPEngine<T, FitnessFunction, Genome>;
+    using GenomeType = typename Engine::GenomeType;
+    using EvolutionStats = typename Engine::EvolutionStats;
+
+    struct Parameters {
+        std::size_t islands = 4;
+        std::size_t migration_interval = 5; // Generations between migrations; 0 disables migration
+        std::size_t migrants = 2;           // Elites sent to each destination per migration
+        MigrationTopology topology = MigrationTopology::RING;
+        std::uint64_t seed = 0;             // Island i runs with derive_seed(seed, streams::ISLAND, i); 0 draws one
+        typename Engine::Parameters island; // Per-island engine parameters; seed is overridden
+    };
+
+    // One generation across all islands, as reported to run()'s callback
+    struct GenerationReport {
+        EvolutionStats stats;              // Best over islands, mean of island averages, summed counters
+        const GenomeType* best;            // Best individual over islands
+        std::uint64_t best_scenario_seed;  // Scenario it was scored under
+        std::size_t best_island;
+    };
+
+    IslandModel(Parameters p, const FitnessFunction& f)
+        : params(std::move(p))
+        , seed(params.seed ? params.seed : (static_cast<std::uint64_t>(std::random_device{}()) << 32 | std::random_device{}())) {
+        if (params.islands == 0) {
+            throw std::invalid_argument("Island model needs at least one island");
+        }
+        if (params.island.mode != EvolutionMode::GENERATIONAL) {
+            throw std::invalid_argument("Island model requires generational islands");
+        }
+        // Emigrants are elites, so every island keeps at least that many
+        params.island.elitism = std::max(params.island.elitism, params.migrants);
+
+        engines.reserve(params.islands);
+        for (std::size_t i = 0; i < params.islands; ++i) {
+            auto island_params = params.island;
+            island_params.seed = derive_seed(seed, streams::ISLAND, i);
+            engines.push_back(std::make_unique<Engine>(island_params, f));
+        }
+        connect();
+    }
+
+    // Fill every island, one after another on the calling thread
+    void initialize_populations(const std::function<GenomeType(std::size_t island)>& generator) {
+        for (std::size_t i = 0; i < engines.size(); ++i) {
+            engines[i]->initialize_population([&] { return generator(i); });
+        }
+    }
+
+    // Evolve every island for the given number of generations.
+    // on_generation runs on the calling thread as soon as all islands have
+    // finished a generation; islands do not wait for it.
+    void run(std::size_t generations, const std::function<void(std::size_t, const GenerationReport&)>& on_generation = nullptr) {
+        const std::size_t n = engines.size();
+        records.assign(n, std::vector<Record>(generations));
+        completed = std::make_unique<std::atomic<std::size_t>[]>(n);
+
+        std::vector<std::thread> threads;
+        threads.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            threads.emplace_back([this, i, generations] { run_island(i, generations); });
+        }
+
+        for (std::size_t gen = 0; gen < generations; ++gen) {
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t done = completed[i].load(std::memory_order_acquire); done <= gen;
+                     done = completed[i].load(std::memory_order_acquire)) {
+                    completed[i].wait(done, std::memory_order_acquire);
+                }
+            }
+            if (on_generation) {
+                on_generation(gen, aggregate(gen));
+            }
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return engines.size();
+    }
+
+    [[nodiscard]] const Engine& island(std::size_t index) const {
+        return *engines.at(index);
+    }
+
+    [[nodiscard]] Engine& island(std::size_t index) {
+        return *engines.at(index);
+    }
+
+    [[nodiscard]] std::uint64_t get_seed() const {
+        return seed;
+    }
+
+private:
+    using Batch = std::vector<GenomeType>;
+
+    struct Record {
+        EvolutionStats stats{};
+        GenomeType best;
+        std::uint64_t best_scenario_seed{0};
+    };
+
+    Parameters params;
+    std::uint64_t seed;
+    std::vector<std::unique_ptr<Engine>> engines;
+    std::vector<std::unique_ptr<SpscQueue<Batch>>> queues;
+    std::vector<std::vector<SpscQueue<Batch>*>> outgoing; // Per island, by destination
+    std::vector<std::vector<SpscQueue<Batch>*>> incoming; // Per island, by source in island order
+    std::vector<std::vector<Record>> records;             // [island][generation], written once by the island
+    std::unique_ptr<std::atomic<std::size_t>[]> completed; // Generations finished per island
+
+    void connect() {
+        const std::size_t n = engines.size();
+        outgoing.assign(n, {});
+        incoming.assign(n, {});
+        if (n < 2 || params.migration_interval == 0) return;
+
+        for (std::size_t to = 0; to < n; ++to) {
+            for (std::size_t from : migration_sources(to, n, params.topology)) {
+                queues.push_back(std::make_unique<SpscQueue<Batch>>(2));
+                outgoing[from].push_back(queues.back().get());
+                incoming[to].push_back(queues.back().get());
+            }
+        }
+    }
+
+    void run_island(std::size_t i, std::size_t generations) {
+        Engine& engine = *engines[i];
+        trace::name_thread("island " + std::to_string(i));
+        for (std::size_t gen = 0; gen < generations; ++gen) {
+            Record& record = records[i][gen];
+            record.stats = engine.evolve_with_stats();
+            record.best = engine.get_best();
+            record.best_scenario_seed = engine.get_best_scenario_seed();
+            completed[i].store(gen + 1, std::memory_order_release);
+            completed[i].notify_all();
+
+            if (migrates_after(gen, generations, engines.size(), params.migration_interval)) {
+                trace::Span span("migration", "engine", "generation", static_cast<std::int64_t>(gen));
+                for (auto* queue : outgoing[i]) {
+                    queue->push(engine.emigrants(params.migrants));
+                }
+                Batch arrivals;
+                for (auto* queue : incoming[i]) {
+                    for (auto& genome : queue->pop()) {
+                        arrivals.push_back(std::move(genome));
+                    }
+                }
+                engine.immigrate(std::move(arrivals));
+            }
+        }
+    }
+
+    [[nodiscard]] GenerationReport aggregate(std::size_t gen) const {
+        auto [stats, i] = aggregate_island_stats(records.size(), [&](std::size_t island) -> const EvolutionStats& {
+            return records[island][gen].stats;
+        });
+        return {stats, &records[i][gen].best, records[i][gen].best_scenario_seed, i};
+    }
+};
+
+} // namespace gp
+
+#endif // GP_ISLAND_HPP
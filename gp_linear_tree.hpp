@@ -0,0 +1,213 @@
+#ifndef GP_LINEAR_TREE_HPP
+#define GP_LINEAR_TREE_HPP
+
+#include "gp_engine.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace gp {
+
+// Flat genome: nodes stored contiguously in prefix order, plus the size of
+// the subtree rooted at every position. A subtree is the half-open range
+// [i, i + extent[i]), so copies are a single memcpy per array and a subtree
+// swap is a memmove. Drop-in for Tree<T> as GPEngine's Genome parameter.
+template<typename T>
+class LinearTree {
+public:
+    std::vector<T> code;              // Node values in prefix order
+    std::vector<std::uint32_t> extent; // Subtree size (in nodes) rooted at each position
+    double fitness{0.0};
+
+    LinearTree() = default;
+
+    // Build from a prefix-order sequence; arity comes from T::children_count()
+    explicit LinearTree(std::span<const T> prefix)
+        : code(prefix.begin(), prefix.end()), extent(prefix.size()) {
+        // Reverse scan: each function node's extent is 1 + its children's extents
+        std::vector<std::uint32_t> sizes;
+        for (size_t i = code.size(); i-- > 0;) {
+            std::uint32_t total = 1;
+            for (size_t c = code[i].children_count(); c > 0 && !sizes.empty(); --c) {
+                total += sizes.back();
+                sizes.pop_back();
+            }
+            extent[i] = total;
+            sizes.push_back(total);
+        }
+    }
+
+    explicit LinearTree(const Tree<T>& tree) : LinearTree(std::span<const T>(tree.prefix())) {
+        fitness = tree.fitness;
+    }
+
+    // Copy of base with the subtree at index replaced by a copy of donor's
+    // subtree at donor_index, assembled from three slices. donor may be base.
+    LinearTree(const LinearTree& base, size_t index, const LinearTree& donor, size_t donor_index)
+        : fitness(base.fitness) {
+        const size_t old_size = base.extent[index];
+        const size_t new_size = donor.extent[donor_index];
+        code.reserve(base.code.size() - old_size + new_size);
+        code.insert(code.end(), base.code.begin(), base.code.begin() + index);
+        code.insert(code.end(), donor.code.begin() + donor_index, donor.code.begin() + donor_index + new_size);
+        code.insert(code.end(), base.code.begin() + index + old_size, base.code.end());
+
+        extent.reserve(code.size());
+        extent.insert(extent.end(), base.extent.begin(), base.extent.begin() + index);
+        extent.insert(extent.end(), donor.extent.begin() + donor_index, donor.extent.begin() + donor_index + new_size);
+        extent.insert(extent.end(), base.extent.begin() + index + old_size, base.extent.end());
+
+        // Every ancestor's range contains index; adjust their sizes
+        const std::int64_t delta = static_cast<std::int64_t>(new_size) - static_cast<std::int64_t>(old_size);
+        for (size_t i = index; i-- > 0;) {
+            if (i + base.extent[i] > index) {
+                extent[i] = static_cast<std::uint32_t>(extent[i] + delta);
+            }
+        }
+    }
+
+    [[nodiscard]] Tree<T> to_tree() const {
+        Tree<T> tree{std::span<const T>(code)};
+        tree.fitness = fitness;
+        return tree;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return code.size();
+    }
+
+    // Node values in prefix order, as Tree::prefix() gives them
+    [[nodiscard]] std::vector<T> prefix() const {
+        return code;
+    }
+
+    [[nodiscard]] size_t depth() const {
+        return code.empty() ? 0 : subtree_depth(0);
+    }
+
+    [[nodiscard]] const T& value_at(size_t index) const {
+        return code[index];
+    }
+
+    void set_value(size_t index, T value) {
+        code[index] = std::move(value);
+    }
+
+    // Prefix index of the k-th child of the node at index
+    [[nodiscard]] size_t child_index(size_t index, size_t k) const {
+        size_t child = index + 1;
+        for (size_t c = 0; c < k; ++c) {
+            child += extent[child];
+        }
+        return child;
+    }
+
+    // Depth of the subtree at index, from one linear scan of its range
+    [[nodiscard]] size_t subtree_depth(size_t index) const {
+        size_t max_depth = 0;
+        std::vector<size_t> open; // Children still missing for each open ancestor
+        const size_t end = index + extent[index];
+        for (size_t i = index; i < end; ++i) {
+            max_depth = std::max(max_depth, open.size() + 1);
+            if (!open.empty()) --open.back();
+            if (size_t arity = code[i].children_count(); arity > 0) {
+                open.push_back(arity);
+            } else {
+                while (!open.empty() && open.back() == 0) {
+                    open.pop_back();
+                }
+            }
+        }
+        return max_depth;
+    }
+
+    // Depth the genome would have if the subtree at index were replaced by
+    // one of depth replacement_depth: the same scan as subtree_depth, with
+    // the replaced range counted as a single node of that depth
+    [[nodiscard]] size_t depth_with_replacement(size_t index, size_t replacement_depth) const {
+        size_t max_depth = 0;
+        std::vector<size_t> open; // Children still missing for each open ancestor
+        for (size_t i = 0; i < code.size();) {
+            const bool replaced = i == index;
+            max_depth = std::max(max_depth, open.size() + (replaced ? replacement_depth : 1));
+            if (!open.empty()) --open.back();
+            if (size_t arity = replaced ? 0 : code[i].children_count(); arity > 0) {
+                open.push_back(arity);
+            } else {
+                while (!open.empty() && open.back() == 0) {
+                    open.pop_back();
+                }
+            }
+            i += replaced ? extent[i] : 1;
+        }
+        return max_depth;
+    }
+
+    // Replace the subtree at index with a copy of donor's subtree at donor_index.
+    // donor may be *this.
+    void replace_subtree(size_t index, const LinearTree& donor, size_t donor_index) {
+        const std::uint32_t old_size = extent[index];
+        const std::uint32_t new_size = donor.extent[donor_index];
+        const std::int64_t delta = static_cast<std::int64_t>(new_size) - old_size;
+
+        if (&donor == this) {
+            // Shrink to a descendant: the donor range lies inside the replaced one
+            const LinearTree copy = slice(donor_index);
+            splice(index, old_size, copy, 0);
+        } else {
+            splice(index, old_size, donor, donor_index);
+        }
+
+        // Every ancestor's range contains index; adjust their sizes
+        for (size_t i = index; i-- > 0;) {
+            if (i + extent[i] > index) {
+                extent[i] = static_cast<std::uint32_t>(extent[i] + delta);
+            }
+        }
+    }
+
+    [[nodiscard]] std::uint64_t hash() const {
+        std::uint64_t h = STRUCTURAL_HASH_SEED;
+        for (const auto& value : code) {
+            h = structural_hash_step(h, value);
+        }
+        return h;
+    }
+
+    // Prefix notation using T::to_char (e.g. "3FLA" for PROGN3 F L A)
+    [[nodiscard]] std::string to_string() const {
+        std::string out;
+        out.reserve(code.size());
+        for (const auto& value : code) {
+            out.push_back(value.to_char());
+        }
+        return out;
+    }
+
+private:
+    [[nodiscard]] LinearTree slice(size_t index) const {
+        LinearTree out;
+        out.code.assign(code.begin() + index, code.begin() + index + extent[index]);
+        out.extent.assign(extent.begin() + index, extent.begin() + index + extent[index]);
+        return out;
+    }
+
+    void splice(size_t index, size_t old_size, const LinearTree& donor, size_t donor_index) {
+        const size_t new_size = donor.extent[donor_index];
+        if (new_size > old_size) {
+            code.insert(code.begin() + index + old_size, new_size - old_size, T{});
+            extent.insert(extent.begin() + index + old_size, new_size - old_size, 0);
+        } else if (new_size < old_size) {
+            code.erase(code.begin() + index + new_size, code.begin() + index + old_size);
+            extent.erase(extent.begin() + index + new_size, extent.begin() + index + old_size);
+        }
+        std::copy_n(donor.code.begin() + donor_index, new_size, code.begin() + index);
+        std::copy_n(donor.extent.begin() + donor_index, new_size, extent.begin() + index);
+    }
+};
+
+} // namespace gp
+
+#endif // GP_LINEAR_TREE_HPP
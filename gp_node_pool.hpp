@@ -0,0 +1,143 @@
+#ifndef GP_NODE_POOL_HPP
+#define GP_NODE_POOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+namespace gp {
+
+// Allocation counters of the calling thread. GPEngine reports their deltas
+// per generation; a thread's numbers cover only the trees it built or freed.
+struct AllocationCounters {
+    std::uint64_t pool_allocations{0};   // Blocks handed out by a pool
+    std::uint64_t pool_deallocations{0}; // Blocks returned to a pool
+    std::uint64_t system_allocations{0}; // Calls into ::operator new (pool chunks and oversized requests)
+};
+
+[[nodiscard]] inline AllocationCounters& allocation_counters() {
+    thread_local AllocationCounters counters;
+    return counters;
+}
+
+// Fixed-size block pool shared by every object of one size.
+//
+// Each thread allocates from and frees to its own free list without
+// locking. Blocks are carved from 64 KiB-ish chunks that are never returned
+// to the system, so a block freed by another thread simply joins that
+// thread's list. When a thread exits its list goes back to a process-wide
+// store, which refills other threads before any new chunk is requested.
+template<std::size_t BlockSize>
+class BlockPool {
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static constexpr std::size_t ALIGNMENT = alignof(std::max_align_t);
+    static constexpr std::size_t BLOCK =
+        (std::max(BlockSize, sizeof(FreeBlock)) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    static constexpr std::size_t BLOCKS_PER_CHUNK = std::max<std::size_t>(64, 65536 / BLOCK);
+
+    struct Store {
+        std::mutex mutex;
+        FreeBlock* free{nullptr}; // Lists handed back by exited threads
+    };
+
+    // Never destroyed: blocks may still be freed during static destruction
+    static Store& store() {
+        static Store* instance = new Store;
+        return *instance;
+    }
+
+    struct LocalList {
+        FreeBlock* head{nullptr};
+
+        ~LocalList() {
+            if (!head) return;
+            FreeBlock* tail = head;
+            while (tail->next) tail = tail->next;
+            std::lock_guard<std::mutex> lock(store().mutex);
+            tail->next = store().free;
+            store().free = head;
+        }
+    };
+
+    static LocalList& local() {
+        thread_local LocalList list;
+        return list;
+    }
+
+    static void refill(LocalList& list) {
+        {
+            std::lock_guard<std::mutex> lock(store().mutex);
+            if (store().free) {
+                list.head = store().free;
+                store().free = nullptr;
+                return;
+            }
+        }
+        auto* chunk = static_cast<std::byte*>(::operator new(BLOCK * BLOCKS_PER_CHUNK));
+        ++allocation_counters().system_allocations;
+        for (std::size_t i = BLOCKS_PER_CHUNK; i-- > 0;) {
+            auto* block = reinterpret_cast<FreeBlock*>(chunk + i * BLOCK);
+            block->next = list.head;
+            list.head = block;
+        }
+    }
+
+public:
+    [[nodiscard]] static void* allocate() {
+        LocalList& list = local();
+        if (!list.head) refill(list);
+        FreeBlock* block = list.head;
+        list.head = block->next;
+        ++allocation_counters().pool_allocations;
+        return block;
+    }
+
+    static void deallocate(void* pointer) noexcept {
+        LocalList& list = local();
+        auto* block = static_cast<FreeBlock*>(pointer);
+        block->next = list.head;
+        list.head = block;
+        ++allocation_counters().pool_deallocations;
+    }
+};
+
+// Standard allocator over BlockPool for small containers (a node's children
+// vector); requests above SMALL_BYTES fall through to ::operator new
+template<typename U>
+struct PoolAllocator {
+    using value_type = U;
+
+    static constexpr std::size_t SMALL_BYTES = 4 * sizeof(void*);
+
+    PoolAllocator() noexcept = default;
+    template<typename V>
+    PoolAllocator(const PoolAllocator<V>&) noexcept {}
+
+    [[nodiscard]] U* allocate(std::size_t n) {
+        if (n * sizeof(U) <= SMALL_BYTES) {
+            return static_cast<U*>(BlockPool<SMALL_BYTES>::allocate());
+        }
+        ++allocation_counters().system_allocations;
+        return static_cast<U*>(::operator new(n * sizeof(U)));
+    }
+
+    void deallocate(U* pointer, std::size_t n) noexcept {
+        if (n * sizeof(U) <= SMALL_BYTES) {
+            BlockPool<SMALL_BYTES>::deallocate(pointer);
+        } else {
+            ::operator delete(pointer);
+        }
+    }
+
+    template<typename V>
+    bool operator==(const PoolAllocator<V>&) const noexcept { return true; }
+};
+
+} // namespace gp
+
+#endif // GP_NODE_POOL_HPP
@@ -0,0 +1,223 @@
+#ifndef GP_PROFILE_HPP
+#define GP_PROFILE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Phase timers and counters for profiling generations.
+//
+// Compiled in only when GP_PROFILE is defined to 1 (CMake option
+// WALLER_PROFILE). Otherwise ScopedPhase is an empty object and count() an
+// empty inline function, so the hooks in the engine and the evaluator cost
+// nothing. When enabled, each thread accumulates into its own slots with
+// steady_clock, and collect() returns what every thread, including threads
+// that have exited since, recorded after the previous collect().
+
+#ifndef GP_PROFILE
+#define GP_PROFILE 0
+#endif
+
+namespace gp::profile {
+
+inline constexpr bool ENABLED = GP_PROFILE != 0;
+
+enum class Phase : std::size_t {
+    EVALUATION,   // Scoring a population, on the engine's thread (wall time)
+    SIMULATION,   // Fitness calls, summed over the threads that ran them
+    RANKING,      // Ranking and statistics
+    SELECTION,    // Tournaments and copies of parents into the next generation
+    CROSSOVER,
+    MUTATION,
+    IMAGE_OUTPUT, // Replay and drawing of the best track, frame hand-off
+    LOGGING,      // Console and data file
+    COUNT
+};
+
+enum class Counter : std::size_t {
+    EVALUATIONS,     // Individuals simulated
+    STEPS,           // Terminals executed over all runs
+    NODES_EVALUATED, // Nodes of the simulated individuals
+    NODES_BRED,      // Nodes of the bred population
+    COUNT
+};
+
+inline constexpr std::size_t PHASES = static_cast<std::size_t>(Phase::COUNT);
+inline constexpr std::size_t COUNTERS = static_cast<std::size_t>(Counter::COUNT);
+
+inline constexpr const char* PHASE_NAMES[PHASES] = {
+    "evaluation", "simulation", "ranking", "selection", "crossover", "mutation", "image_output", "logging"
+};
+inline constexpr const char* COUNTER_NAMES[COUNTERS] = {
+    "evaluations", "steps", "nodes_evaluated", "nodes_bred"
+};
+
+// Numbers of one thread, or summed over threads
+struct Totals {
+    std::array<std::uint64_t, PHASES> nanoseconds{};
+    std::array<std::uint64_t, COUNTERS> counts{};
+
+    [[nodiscard]] double milliseconds(Phase phase) const {
+        return static_cast<double>(nanoseconds[static_cast<std::size_t>(phase)]) / 1e6;
+    }
+
+    [[nodiscard]] std::uint64_t count(Counter counter) const {
+        return counts[static_cast<std::size_t>(counter)];
+    }
+
+    [[nodiscard]] bool empty() const {
+        return std::all_of(nanoseconds.begin(), nanoseconds.end(), [](auto v) { return v == 0; }) &&
+               std::all_of(counts.begin(), counts.end(), [](auto v) { return v == 0; });
+    }
+
+    Totals& operator+=(const Totals& other) {
+        for (std::size_t i = 0; i < PHASES; ++i) nanoseconds[i] += other.nanoseconds[i];
+        for (std::size_t i = 0; i < COUNTERS; ++i) counts[i] += other.counts[i];
+        return *this;
+    }
+};
+
+// What happened between two collect() calls
+struct Interval {
+    Totals totals;                   // Summed over threads
+    std::size_t threads{0};          // Threads that recorded anything
+    double busiest_simulation_ms{0}; // SIMULATION time of the busiest thread; against
+                                     // simulation / threads it shows load imbalance
+};
+
+#if GP_PROFILE
+
+namespace detail {
+
+// One thread's numbers. Only the owner writes them; collect() reads them
+// from another thread, hence relaxed atomics.
+struct Slots {
+    std::array<std::atomic<std::uint64_t>, PHASES> nanoseconds{};
+    std::array<std::atomic<std::uint64_t>, COUNTERS> counts{};
+    Totals collected; // Values at the last collect(), under the registry mutex
+
+    static void add(std::atomic<std::uint64_t>& slot, std::uint64_t value) {
+        slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    // Numbers since the last collect(), which then start from here
+    Totals take() {
+        Totals delta;
+        for (std::size_t i = 0; i < PHASES; ++i) {
+            const std::uint64_t now = nanoseconds[i].load(std::memory_order_relaxed);
+            delta.nanoseconds[i] = now - collected.nanoseconds[i];
+            collected.nanoseconds[i] = now;
+        }
+        for (std::size_t i = 0; i < COUNTERS; ++i) {
+            const std::uint64_t now = counts[i].load(std::memory_order_relaxed);
+            delta.counts[i] = now - collected.counts[i];
+            collected.counts[i] = now;
+        }
+        return delta;
+    }
+};
+
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    void attach(Slots* slots) {
+        std::lock_guard lock(mutex);
+        live.push_back(slots);
+    }
+
+    // An exiting thread's uncollected numbers wait for the next collect()
+    void detach(Slots* slots) {
+        std::lock_guard lock(mutex);
+        if (Totals rest = slots->take(); !rest.empty()) exited.push_back(rest);
+        live.erase(std::find(live.begin(), live.end(), slots));
+    }
+
+    [[nodiscard]] Interval collect() {
+        std::lock_guard lock(mutex);
+        Interval interval;
+        auto add = [&](const Totals& thread) {
+            if (thread.empty()) return;
+            interval.totals += thread;
+            ++interval.threads;
+            interval.busiest_simulation_ms = std::max(interval.busiest_simulation_ms, thread.milliseconds(Phase::SIMULATION));
+        };
+        for (Slots* slots : live) add(slots->take());
+        for (const Totals& thread : exited) add(thread);
+        exited.clear();
+        return interval;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<Slots*> live;
+    std::vector<Totals> exited; // Threads that ended since the last collect()
+};
+
+struct ThreadSlots {
+    Slots slots;
+    ThreadSlots() { Registry::instance().attach(&slots); }
+    ~ThreadSlots() { Registry::instance().detach(&slots); }
+};
+
+inline Slots& thread_slots() {
+    thread_local ThreadSlots local;
+    return local.slots;
+}
+
+} // namespace detail
+
+// Adds the time from construction to destruction to a phase of the calling thread
+class ScopedPhase {
+public:
+    explicit ScopedPhase(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~ScopedPhase() {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        detail::Slots::add(detail::thread_slots().nanoseconds[static_cast<std::size_t>(phase)],
+                           static_cast<std::uint64_t>(elapsed.count()));
+    }
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+inline void count(Counter counter, std::uint64_t value) {
+    detail::Slots::add(detail::thread_slots().counts[static_cast<std::size_t>(counter)], value);
+}
+
+// Everything recorded since the previous call, by every thread. Meant for
+// a single caller, such as the loop that reports generations.
+[[nodiscard]] inline Interval collect() {
+    return detail::Registry::instance().collect();
+}
+
+#else
+
+class ScopedPhase {
+public:
+    explicit ScopedPhase(Phase) {}
+};
+
+inline void count(Counter, std::uint64_t) {}
+
+[[nodiscard]] inline Interval collect() {
+    return {};
+}
+
+#endif
+
+} // namespace gp::profile
+
+#endif // GP_PROFILE_HPP
@@ -0,0 +1,75 @@
+#ifndef GP_RANDOM_HPP
+#define GP_RANDOM_HPP
+
+#include <cstdint>
+#include <limits>
+
+namespace gp {
+
+// SplitMix64 finalizer: a bijective 64-bit mix
+[[nodiscard]] constexpr std::uint64_t mix64(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Independent sub-streams of one run seed. Every consumer of randomness
+// derives its own seed from the run seed and its stream id, so adding draws
+// to one component never shifts another.
+namespace streams {
+inline constexpr std::uint64_t ENGINE = 1;         // Selection, crossover and mutation
+inline constexpr std::uint64_t TREE_GENERATOR = 2; // Initial population
+inline constexpr std::uint64_t SCENARIO = 3;       // Scenario seed per generation (index = scenario number)
+inline constexpr std::uint64_t RUN = 4;            // Start positions per run (index = run number)
+inline constexpr std::uint64_t ISLAND = 5;         // Run seed of each island (index = island number)
+}
+
+// Counter-based derivation: the seed for (stream, index) is a pure function
+// of its inputs, so workers can compute theirs without shared state
+[[nodiscard]] constexpr std::uint64_t derive_seed(std::uint64_t seed, std::uint64_t stream, std::uint64_t index = 0) {
+    return mix64(mix64(seed ^ mix64(stream)) + index * 0x9e3779b97f4a7c15ULL);
+}
+
+// SplitMix64 generator: 64 bits of state, one add and one mix per draw.
+// Satisfies UniformRandomBitGenerator. The bounded helpers below are used
+// instead of the std:: distributions so results do not depend on the
+// standard library implementation.
+class Rng {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Rng(std::uint64_t seed = 0) : s(seed) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        s += 0x9e3779b97f4a7c15ULL;
+        return mix64(s);
+    }
+
+    // Uniform integer in [0, n) by multiply-shift; bias is below n / 2^64
+    std::uint64_t below(std::uint64_t n) {
+        return static_cast<std::uint64_t>((static_cast<unsigned __int128>((*this)()) * n) >> 64);
+    }
+
+    // Uniform integer in [lo, hi]
+    int uniform(int lo, int hi) {
+        return lo + static_cast<int>(below(static_cast<std::uint64_t>(hi - lo) + 1));
+    }
+
+    // Uniform double in [0, 1)
+    double unit() {
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    [[nodiscard]] std::uint64_t state() const { return s; }
+    void set_state(std::uint64_t state) { s = state; }
+
+private:
+    std::uint64_t s;
+};
+
+} // namespace gp
+
+#endif // GP_RANDOM_HPP
@@ -0,0 +1,354 @@
+#ifndef GP_SERIALIZE_HPP
+#define GP_SERIALIZE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gp_engine.hpp"
+
+namespace gp {
+
+// Append-only little-endian byte buffer
+class ByteWriter {
+public:
+    std::vector<std::uint8_t> bytes;
+
+    void put_u8(std::uint8_t value) {
+        bytes.push_back(value);
+    }
+
+    void put_u32(std::uint32_t value) {
+        for (int i = 0; i < 4; ++i) bytes.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+
+    void put_u64(std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) bytes.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+
+    void put_f64(double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        put_u64(bits);
+    }
+
+    // LEB128: 7 bits per byte, high bit set on all but the last
+    void put_varint(std::uint64_t value) {
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    void put_bytes(std::span<const std::uint8_t> data) {
+        bytes.insert(bytes.end(), data.begin(), data.end());
+    }
+};
+
+// Reader over a byte span; throws std::runtime_error on truncated input
+class ByteReader {
+public:
+    explicit ByteReader(std::span<const std::uint8_t> data) : data(data) {}
+
+    std::uint8_t get_u8() {
+        need(1);
+        return data[position++];
+    }
+
+    std::uint32_t get_u32() {
+        need(4);
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) value |= static_cast<std::uint32_t>(data[position++]) << (8 * i);
+        return value;
+    }
+
+    std::uint64_t get_u64() {
+        need(8);
+        std::uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) value |= static_cast<std::uint64_t>(data[position++]) << (8 * i);
+        return value;
+    }
+
+    double get_f64() {
+        std::uint64_t bits = get_u64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::uint64_t get_varint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::uint8_t byte = get_u8();
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Malformed varint");
+    }
+
+    std::span<const std::uint8_t> get_bytes(std::size_t count) {
+        need(count);
+        auto out = data.subspan(position, count);
+        position += count;
+        return out;
+    }
+
+    [[nodiscard]] std::size_t remaining() const {
+        return data.size() - position;
+    }
+
+private:
+    std::span<const std::uint8_t> data;
+    std::size_t position{0};
+
+    void need(std::size_t count) const {
+        if (data.size() - position < count) {
+            throw std::runtime_error("Unexpected end of serialized data");
+        }
+    }
+};
+
+// Fixed-width code of a node value for genome serialization. Specialize
+// with BITS (at most 8), encode(value) and decode(code); decode throws
+// std::runtime_error on a code it does not know.
+template<typename T>
+struct value_codec;
+
+namespace detail {
+
+// Node codes packed BITS bits each (low bits first) in prefix order; the
+// last byte is zero-padded
+template<typename T>
+void put_codes(ByteWriter& out, std::span<const T> prefix) {
+    constexpr unsigned BITS = value_codec<T>::BITS;
+    static_assert(BITS >= 1 && BITS <= 8, "value_codec<T>::BITS must be in [1, 8]");
+
+    std::uint32_t pending = 0;
+    unsigned filled = 0;
+    for (const auto& value : prefix) {
+        pending |= static_cast<std::uint32_t>(value_codec<T>::encode(value)) << filled;
+        filled += BITS;
+        while (filled >= 8) {
+            out.put_u8(static_cast<std::uint8_t>(pending));
+            pending >>= 8;
+            filled -= 8;
+        }
+    }
+    if (filled > 0) out.put_u8(static_cast<std::uint8_t>(pending));
+}
+
+// count node codes written by put_codes, checked to form exactly one tree
+template<typename T>
+[[nodiscard]] std::vector<T> get_codes(ByteReader& in, std::uint64_t count) {
+    constexpr unsigned BITS = value_codec<T>::BITS;
+    if (count > (in.remaining() * 8) / BITS) {
+        throw std::runtime_error("Genome length exceeds the serialized data");
+    }
+
+    std::vector<T> prefix;
+    prefix.reserve(count);
+    std::uint32_t pending = 0;
+    unsigned available = 0;
+    std::size_t open = 1; // Subtrees still to be read
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (available < BITS) {
+            pending |= static_cast<std::uint32_t>(in.get_u8()) << available;
+            available += 8;
+        }
+        if (open == 0) throw std::runtime_error("Genome has nodes past its root's subtree");
+        prefix.push_back(value_codec<T>::decode(static_cast<std::uint8_t>(pending & ((1u << BITS) - 1))));
+        pending >>= BITS;
+        available -= BITS;
+        open = open - 1 + prefix.back().children_count();
+    }
+    if (count > 0 && open != 0) throw std::runtime_error("Genome ends inside a subtree");
+    return prefix;
+}
+
+} // namespace detail
+
+// Genome wire format: varint node count, the node codes (detail::put_codes),
+// then the fitness as a double
+template<typename T>
+void write_genome(ByteWriter& out, std::span<const T> prefix, double fitness) {
+    out.put_varint(prefix.size());
+    detail::put_codes(out, prefix);
+    out.put_f64(fitness);
+}
+
+template<typename T>
+void write_genome(ByteWriter& out, const Tree<T>& tree) {
+    const auto prefix = tree.prefix();
+    write_genome(out, std::span<const T>(prefix), tree.fitness);
+}
+
+namespace detail {
+
+template<typename GenomeType, typename T>
+void write_any_genome(ByteWriter& out, const GenomeType& genome) {
+    const std::vector<T> prefix = genome.prefix();
+    write_genome(out, std::span<const T>(prefix), genome.fitness);
+}
+
+template<typename GenomeType, typename T>
+[[nodiscard]] GenomeType read_any_genome(ByteReader& in) {
+    const std::vector<T> prefix = get_codes<T>(in, in.get_varint());
+    GenomeType genome{std::span<const T>(prefix)};
+    genome.fitness = in.get_f64();
+    return genome;
+}
+
+[[nodiscard]] inline std::size_t get_count(ByteReader& in, std::size_t min_bytes_each) {
+    const std::uint64_t count = in.get_varint();
+    if (count > in.remaining() / min_bytes_each) {
+        throw std::runtime_error("Element count exceeds the serialized data");
+    }
+    return static_cast<std::size_t>(count);
+}
+
+} // namespace detail
+
+// Decode one genome, checking that the codes form exactly one tree
+template<typename T, template<typename> class Genome = Tree>
+[[nodiscard]] Genome<T> read_genome(ByteReader& in) {
+    return detail::read_any_genome<Genome<T>, T>(in);
+}
+
+inline constexpr std::uint32_t ENGINE_STATE_VERSION = 1;
+
+// GPEngine::State format: version, parameters (without num_threads), seeds
+// and counters, population, best, fitness cache (most recently used first),
+// then the steady-state pipeline. Sizes are varints, seeds raw u64s.
+template<typename Engine>
+void write_engine_state(ByteWriter& out, const typename Engine::State& state) {
+    using T = typename Engine::ValueType;
+    using GenomeType = typename Engine::GenomeType;
+    const auto& params = state.params;
+
+    out.put_u32(ENGINE_STATE_VERSION);
+    out.put_varint(params.population_size);
+    out.put_varint(params.generations);
+    out.put_f64(params.crossover_rate);
+    out.put_f64(params.mutation_rate);
+    out.put_varint(params.tournament_size);
+    out.put_varint(params.max_depth);
+    out.put_varint(params.max_nodes);
+    out.put_u64(params.seed);
+    out.put_varint(params.cache_capacity);
+    out.put_varint(params.scenario_interval);
+    out.put_varint(params.elitism);
+    out.put_u8(static_cast<std::uint8_t>(params.mode));
+    out.put_u8(static_cast<std::uint8_t>(params.replacement));
+    out.put_varint(params.steady_state_window);
+
+    out.put_u64(state.seed);
+    out.put_u64(state.rng_state);
+    out.put_u64(state.scenario_seed);
+    out.put_varint(state.generation);
+    out.put_varint(state.population.size());
+    for (const auto& individual : state.population) {
+        detail::write_any_genome<GenomeType, T>(out, individual);
+    }
+    detail::write_any_genome<GenomeType, T>(out, state.best);
+    out.put_u64(state.best_scenario_seed);
+    out.put_varint(state.cache.size());
+    for (const auto& [key, fitness] : state.cache) {
+        out.put_u64(key.genome_hash);
+        out.put_u64(key.scenario_seed);
+        out.put_f64(fitness);
+    }
+
+    out.put_u8(state.streaming ? 1 : 0);
+    if (!state.streaming) return;
+    out.put_varint(state.best_index);
+    out.put_varint(state.offspring_produced);
+    for (std::uint64_t individual_seed : state.individual_seeds) {
+        out.put_u64(individual_seed);
+    }
+    out.put_varint(state.window.size());
+    for (const auto& slot : state.window) {
+        detail::write_any_genome<GenomeType, T>(out, slot.genome);
+        out.put_u64(slot.scenario_seed);
+        out.put_u64(slot.key.genome_hash);
+        out.put_u64(slot.key.scenario_seed);
+        out.put_u8(static_cast<std::uint8_t>((slot.cached ? 1 : 0) | (slot.done ? 2 : 0)));
+    }
+}
+
+template<typename Engine>
+[[nodiscard]] typename Engine::State read_engine_state(ByteReader& in) {
+    using T = typename Engine::ValueType;
+    using GenomeType = typename Engine::GenomeType;
+    constexpr std::size_t MIN_GENOME_BYTES = 9; // Empty genome: count and fitness
+
+    if (std::uint32_t version = in.get_u32(); version != ENGINE_STATE_VERSION) {
+        throw std::runtime_error("Unsupported engine state version " + std::to_string(version));
+    }
+    typename Engine::State state;
+    auto& params = state.params;
+    params.population_size = in.get_varint();
+    params.generations = in.get_varint();
+    params.crossover_rate = in.get_f64();
+    params.mutation_rate = in.get_f64();
+    params.tournament_size = in.get_varint();
+    params.max_depth = in.get_varint();
+    params.max_nodes = in.get_varint();
+    params.seed = in.get_u64();
+    params.cache_capacity = in.get_varint();
+    params.scenario_interval = in.get_varint();
+    params.elitism = in.get_varint();
+    const std::uint8_t mode = in.get_u8();
+    const std::uint8_t replacement = in.get_u8();
+    if (mode > static_cast<std::uint8_t>(EvolutionMode::STEADY_STATE) ||
+        replacement > static_cast<std::uint8_t>(Replacement::TOURNAMENT)) {
+        throw std::runtime_error("Unknown evolution mode or replacement in engine state");
+    }
+    params.mode = static_cast<EvolutionMode>(mode);
+    params.replacement = static_cast<Replacement>(replacement);
+    params.steady_state_window = in.get_varint();
+
+    state.seed = in.get_u64();
+    state.rng_state = in.get_u64();
+    state.scenario_seed = in.get_u64();
+    state.generation = in.get_varint();
+    state.population.resize(detail::get_count(in, MIN_GENOME_BYTES));
+    for (auto& individual : state.population) {
+        individual = detail::read_any_genome<GenomeType, T>(in);
+    }
+    state.best = detail::read_any_genome<GenomeType, T>(in);
+    state.best_scenario_seed = in.get_u64();
+    state.cache.resize(detail::get_count(in, 24));
+    for (auto& [key, fitness] : state.cache) {
+        key.genome_hash = in.get_u64();
+        key.scenario_seed = in.get_u64();
+        fitness = in.get_f64();
+    }
+
+    state.streaming = in.get_u8() != 0;
+    if (!state.streaming) return state;
+    state.best_index = in.get_varint();
+    state.offspring_produced = in.get_varint();
+    state.individual_seeds.resize(state.population.size());
+    for (auto& individual_seed : state.individual_seeds) {
+        individual_seed = in.get_u64();
+    }
+    state.window.resize(detail::get_count(in, MIN_GENOME_BYTES + 25));
+    for (auto& slot : state.window) {
+        slot.genome = detail::read_any_genome<GenomeType, T>(in);
+        slot.scenario_seed = in.get_u64();
+        slot.key.genome_hash = in.get_u64();
+        slot.key.scenario_seed = in.get_u64();
+        const std::uint8_t flags = in.get_u8();
+        slot.cached = (flags & 1) != 0;
+        slot.done = (flags & 2) != 0;
+    }
+    return state;
+}
+
+} // namespace gp
+
+#endif // GP_SERIALIZE_HPP
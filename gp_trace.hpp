@@ -0,0 +1,235 @@
+#ifndef GP_TRACE_HPP
+#define GP_TRACE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Span tracing in Chrome's trace_event format.
+//
+// Compiled in only when GP_TRACE is defined to 1 (CMake option
+// WALLER_TRACE); otherwise Span is an empty object. When compiled in,
+// spans are recorded between start() and write(), which saves a JSON file
+// that chrome://tracing or Perfetto open directly. Each thread appends to a
+// buffer of its own under a small numeric thread ID; when a thread exits
+// the ID and buffer go to the next new thread, so short-lived evaluation
+// workers share a handful of rows instead of adding rows every generation.
+
+#ifndef GP_TRACE
+#define GP_TRACE 0
+#endif
+
+namespace gp::trace {
+
+inline constexpr bool ENABLED = GP_TRACE != 0;
+
+#if GP_TRACE
+
+namespace detail {
+
+using Clock = std::chrono::steady_clock;
+
+struct Event {
+    const char* name;     // String literals only: stored by pointer
+    const char* category;
+    const char* arg_name; // Optional integer argument
+    std::int64_t arg;
+    Clock::time_point start;
+    Clock::duration duration;
+};
+
+struct Buffer {
+    int tid;
+    std::mutex mutex; // Uncontended except while write() reads the events
+    std::string thread_name;
+    std::vector<Event> events;
+};
+
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    std::atomic<bool> recording{false};
+    Clock::time_point origin;
+
+    // Lowest free thread ID, with its buffer. A reused buffer keeps its
+    // events but not the previous owner's name; until the new thread names
+    // itself the row is labelled by ID. An exited thread's name stays while
+    // its buffer is free.
+    Buffer* acquire() {
+        std::lock_guard lock(mutex);
+        for (auto& buffer : buffers) {
+            if (std::find(in_use.begin(), in_use.end(), buffer.get()) == in_use.end()) {
+                in_use.push_back(buffer.get());
+                std::lock_guard events_lock(buffer->mutex);
+                buffer->thread_name.clear();
+                return buffer.get();
+            }
+        }
+        buffers.push_back(std::make_unique<Buffer>());
+        buffers.back()->tid = static_cast<int>(buffers.size());
+        in_use.push_back(buffers.back().get());
+        return buffers.back().get();
+    }
+
+    void release(Buffer* buffer) {
+        std::lock_guard lock(mutex);
+        in_use.erase(std::find(in_use.begin(), in_use.end(), buffer));
+    }
+
+    void clear() {
+        std::lock_guard lock(mutex);
+        for (auto& buffer : buffers) {
+            std::lock_guard events_lock(buffer->mutex);
+            buffer->events.clear();
+        }
+    }
+
+    bool write(const std::string& path);
+
+private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Buffer>> buffers; // Index + 1 is the thread ID
+    std::vector<Buffer*> in_use;
+};
+
+struct ThreadBuffer {
+    Buffer* buffer = Registry::instance().acquire();
+    ~ThreadBuffer() { Registry::instance().release(buffer); }
+};
+
+inline Buffer& thread_buffer() {
+    thread_local ThreadBuffer local;
+    return *local.buffer;
+}
+
+inline void escape(std::ostream& out, const std::string& text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out << c;
+    }
+}
+
+inline bool Registry::write(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    std::lock_guard lock(mutex);
+    auto microseconds = [](Clock::duration d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    };
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&] {
+        if (!first) out << ",";
+        out << "\n";
+        first = false;
+    };
+    out.precision(3);
+    out << std::fixed;
+    for (auto& buffer : buffers) {
+        std::lock_guard events_lock(buffer->mutex);
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":\"";
+        escape(out, buffer->thread_name.empty() ? "thread " + std::to_string(buffer->tid) : buffer->thread_name);
+        out << "\"}}";
+        for (const Event& event : buffer->events) {
+            separator();
+            out << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":" << microseconds(event.start - origin)
+                << ",\"dur\":" << microseconds(event.duration);
+            if (event.arg_name) {
+                out << ",\"args\":{\"" << event.arg_name << "\":" << event.arg << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace detail
+
+// Begin recording; timestamps count from here
+inline void start() {
+    auto& registry = detail::Registry::instance();
+    registry.clear();
+    registry.origin = detail::Clock::now();
+    registry.recording.store(true, std::memory_order_release);
+}
+
+[[nodiscard]] inline bool recording() {
+    return detail::Registry::instance().recording.load(std::memory_order_relaxed);
+}
+
+// Stop recording and save every span so far; false if the file cannot be written
+inline bool write(const std::string& path) {
+    auto& registry = detail::Registry::instance();
+    registry.recording.store(false, std::memory_order_release);
+    return registry.write(path);
+}
+
+// Row label of the calling thread in the viewer
+inline void name_thread(std::string name) {
+    if (!recording()) return;
+    detail::Buffer& buffer = detail::thread_buffer();
+    std::lock_guard lock(buffer.mutex);
+    buffer.thread_name = std::move(name);
+}
+
+// Records its lifetime as a complete ("X") event on the calling thread.
+// name, category and arg_name must be string literals.
+class Span {
+public:
+    explicit Span(const char* name, const char* category, const char* arg_name = nullptr, std::int64_t arg = 0)
+        : name(name), category(category), arg_name(arg_name), arg(arg) {
+        if (recording()) start = detail::Clock::now();
+    }
+
+    ~Span() {
+        if (start == detail::Clock::time_point{} || !recording()) return;
+        const auto end = detail::Clock::now();
+        detail::Buffer& buffer = detail::thread_buffer();
+        std::lock_guard lock(buffer.mutex);
+        buffer.events.push_back({name, category, arg_name, arg, start, end - start});
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    const char* arg_name;
+    std::int64_t arg;
+    detail::Clock::time_point start{};
+};
+
+#else
+
+inline void start() {}
+[[nodiscard]] inline bool recording() { return false; }
+inline bool write(const std::string&) { return false; }
+template<typename Name> inline void name_thread(const Name&) {}
+
+class Span {
+public:
+    explicit Span(const char*, const char*, const char* = nullptr, std::int64_t = 0) {}
+};
+
+#endif
+
+} // namespace gp::trace
+
+#endif // GP_TRACE_HPP
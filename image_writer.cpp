@@ -0,0 +1,173 @@
+#include "image_writer.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "gp_trace.hpp"
+
+namespace {
+
+std::array<std::uint32_t, 256> makeCrcTable() {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t n = 0; n < 256; n++) {
+        std::uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        table[n] = c;
+    }
+    return table;
+}
+
+std::uint32_t crc32(const unsigned char* data, size_t length, std::uint32_t crc = 0) {
+    static const std::array<std::uint32_t, 256> table = makeCrcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void putBigEndian(std::vector<unsigned char>& out, std::uint32_t value) {
+    out.push_back((unsigned char)(value >> 24));
+    out.push_back((unsigned char)(value >> 16));
+    out.push_back((unsigned char)(value >> 8));
+    out.push_back((unsigned char)value);
+}
+
+// Chunk = length, type, data, CRC over type + data
+void putChunk(std::vector<unsigned char>& out, const char type[4], const std::vector<unsigned char>& data) {
+    putBigEndian(out, (std::uint32_t)data.size());
+    size_t typeStart = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    putBigEndian(out, crc32(&out[typeStart], 4 + data.size()));
+}
+
+bool writeFile(const std::string& path, const std::vector<unsigned char>& bytes) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to create image file " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok) {
+        std::cerr << "Failed to write image file " << path << ": " << std::strerror(errno) << "\n";
+    }
+    return ok;
+}
+
+} // namespace
+
+bool writePPM(const std::string& path, const unsigned char* rgb, int width, int height) {
+    std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    std::vector<unsigned char> bytes(header.begin(), header.end());
+    bytes.insert(bytes.end(), rgb, rgb + (size_t)width * height * 3);
+    return writeFile(path, bytes);
+}
+
+bool writePNG(const std::string& path, const unsigned char* rgb, int width, int height) {
+    static const unsigned char SIGNATURE[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<unsigned char> bytes(SIGNATURE, SIGNATURE + sizeof(SIGNATURE));
+
+    std::vector<unsigned char> ihdr;
+    putBigEndian(ihdr, (std::uint32_t)width);
+    putBigEndian(ihdr, (std::uint32_t)height);
+    ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0}); // 8-bit RGB, deflate, no filter, no interlace
+    putChunk(bytes, "IHDR", ihdr);
+
+    // Scanlines: filter type 0 followed by the row's pixels
+    const size_t rowBytes = (size_t)width * 3;
+    std::vector<unsigned char> raw;
+    raw.reserve((rowBytes + 1) * height);
+    for (int lin = 0; lin < height; lin++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb + lin * rowBytes, rgb + (lin + 1) * rowBytes);
+    }
+
+    // zlib stream of stored deflate blocks (max 65535 bytes each) + Adler-32
+    std::vector<unsigned char> idat = {0x78, 0x01};
+    for (size_t offset = 0;;) {
+        size_t length = std::min<size_t>(65535, raw.size() - offset);
+        bool last = offset + length == raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back((unsigned char)length);
+        idat.push_back((unsigned char)(length >> 8));
+        idat.push_back((unsigned char)~length);
+        idat.push_back((unsigned char)(~length >> 8));
+        idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + length);
+        offset += length;
+        if (last) break;
+    }
+    std::uint32_t a = 1, b = 0;
+    for (unsigned char byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    putBigEndian(idat, (b << 16) | a);
+    putChunk(bytes, "IDAT", idat);
+    putChunk(bytes, "IEND", {});
+
+    return writeFile(path, bytes);
+}
+
+bool writeImage(const std::string& path, const unsigned char* rgb, int width, int height, ImageFormat format) {
+    return format == ImageFormat::PNG ? writePNG(path, rgb, width, height)
+                                      : writePPM(path, rgb, width, height);
+}
+
+AsyncFrameWriter::AsyncFrameWriter(ImageFormat format)
+    : format(format)
+    , worker(&AsyncFrameWriter::loop, this) {}
+
+AsyncFrameWriter::~AsyncFrameWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void AsyncFrameWriter::submit(std::string path, const unsigned char* rgb, int width, int height) {
+    Frame frame{std::move(path), std::vector<unsigned char>(rgb, rgb + (size_t)width * height * 3), width, height};
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        space.wait(lock, [this] { return queue.size() < MAX_QUEUED; });
+        queue.push_back(std::move(frame));
+    }
+    wake.notify_one();
+}
+
+void AsyncFrameWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    drained.wait(lock, [this] { return queue.empty() && !busy; });
+}
+
+void AsyncFrameWriter::loop() {
+    gp::trace::name_thread("frame writer");
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) return; // Stopping with nothing left to write
+
+        Frame frame = std::move(queue.front());
+        queue.pop_front();
+        busy = true;
+        space.notify_one();
+        lock.unlock();
+        {
+            gp::trace::Span span("writeImage", "io");
+            writeImage(frame.path, frame.rgb.data(), frame.width, frame.height, format);
+        }
+        lock.lock();
+        busy = false;
+        if (queue.empty()) drained.notify_all();
+    }
+}
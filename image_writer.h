@@ -0,0 +1,64 @@
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ImageFormat {
+    PPM,    // Binary P6
+    PNG     // RGB8, stored (uncompressed) deflate blocks
+};
+
+// Encode an RGB8 image (row-major, 3 bytes per pixel) into a file.
+// Both writers go through one buffered write; no external tools involved.
+// They return false, after reporting the error on stderr, if the file
+// cannot be created or fully written.
+bool writePPM(const std::string& path, const unsigned char* rgb, int width, int height);
+bool writePNG(const std::string& path, const unsigned char* rgb, int width, int height);
+bool writeImage(const std::string& path, const unsigned char* rgb, int width, int height, ImageFormat format);
+
+// Writes frames on a background thread so the caller does not wait on disk.
+// submit() copies the pixels and returns at once unless MAX_QUEUED frames
+// are already waiting, in which case it blocks until one is written, so a
+// slow disk cannot grow memory without bound. Failed writes are reported
+// on stderr. The destructor finishes every queued frame before joining.
+class AsyncFrameWriter {
+public:
+    explicit AsyncFrameWriter(ImageFormat format);
+    ~AsyncFrameWriter();
+
+    AsyncFrameWriter(const AsyncFrameWriter&) = delete;
+    AsyncFrameWriter& operator=(const AsyncFrameWriter&) = delete;
+
+    void submit(std::string path, const unsigned char* rgb, int width, int height);
+    void flush(); // Block until the queue is empty
+
+    static constexpr std::size_t MAX_QUEUED = 8;
+
+private:
+    struct Frame {
+        std::string path;
+        std::vector<unsigned char> rgb;
+        int width;
+        int height;
+    };
+
+    void loop();
+
+    ImageFormat format;
+    std::deque<Frame> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::condition_variable space; // A queued frame was taken
+    bool busy = false;
+    bool stopping = false;
+    std::thread worker;
+};
+
+#endif // IMAGE_WRITER_H
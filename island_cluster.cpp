@@ -0,0 +1,353 @@
+#include "island_cluster.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gp_serialize.hpp"
+#include "net_channel.h"
+
+extern char** environ;
+
+namespace {
+
+using Genome = ClusterEngine::GenomeType;
+
+// Message types
+enum : std::uint8_t {
+    HELLO = 1,    // Coordinator -> worker: island assignment and run settings
+    STATS = 2,    // Worker -> coordinator: one generation's stats and best
+    MIGRANTS = 3, // Both ways: a batch of emigrants, relayed unchanged
+    FINAL = 4     // Worker -> coordinator: final individuals; the worker is done
+};
+
+struct Hello {
+    std::uint32_t island;
+    std::uint32_t islands;
+    std::uint64_t seed;
+    std::uint32_t generations;
+    std::uint32_t migrationInterval;
+    std::uint32_t migrants;
+    std::uint8_t topology;
+    std::uint32_t threads;
+    std::uint32_t finalCount;
+    std::uint32_t runs;
+};
+
+void putGenomes(gp::ByteWriter& out, const std::vector<Genome>& genomes) {
+    out.put_varint(genomes.size());
+    for (const auto& genome : genomes) {
+        gp::write_genome(out, genome);
+    }
+}
+
+std::vector<Genome> getGenomes(gp::ByteReader& in) {
+    std::vector<Genome> genomes(in.get_varint());
+    for (auto& genome : genomes) {
+        genome = gp::read_genome<robot_gp::RobotNodeValue>(in);
+    }
+    return genomes;
+}
+
+void putStats(gp::ByteWriter& out, const ClusterEngine::EvolutionStats& stats) {
+    out.put_f64(stats.best_fitness);
+    out.put_f64(stats.average_fitness);
+    out.put_u64(stats.cache_hits);
+    out.put_u64(stats.cache_misses);
+    out.put_u64(stats.allocations.pool_allocations);
+    out.put_u64(stats.allocations.pool_deallocations);
+    out.put_u64(stats.allocations.system_allocations);
+}
+
+ClusterEngine::EvolutionStats getStats(gp::ByteReader& in) {
+    ClusterEngine::EvolutionStats stats{};
+    stats.best_fitness = in.get_f64();
+    stats.average_fitness = in.get_f64();
+    stats.cache_hits = in.get_u64();
+    stats.cache_misses = in.get_u64();
+    stats.allocations.pool_allocations = in.get_u64();
+    stats.allocations.pool_deallocations = in.get_u64();
+    stats.allocations.system_allocations = in.get_u64();
+    return stats;
+}
+
+// How often the coordinator looks at its spawned workers while waiting
+// for them to connect
+constexpr int CONNECT_POLL_MS = 100;
+
+// Spawned worker processes. Any still running when this is destroyed,
+// normally because the coordinator is unwinding from an error, are killed
+// and reaped.
+class WorkerProcesses {
+public:
+    WorkerProcesses() = default;
+    ~WorkerProcesses() {
+        for (pid_t child : children) {
+            ::kill(child, SIGKILL);
+            int status;
+            while (waitpid(child, &status, 0) < 0 && errno == EINTR) {}
+        }
+    }
+
+    WorkerProcesses(const WorkerProcesses&) = delete;
+    WorkerProcesses& operator=(const WorkerProcesses&) = delete;
+
+    void spawn(const std::string& program, const std::string& address, std::size_t count) {
+        for (std::size_t i = 0; i < count; i++) {
+            std::string arg0 = program, flag = "--worker", where = address;
+            char* argv[] = {arg0.data(), flag.data(), where.data(), nullptr};
+            pid_t pid;
+            if (int rc = posix_spawn(&pid, program.c_str(), nullptr, nullptr, argv, environ); rc != 0) {
+                throw std::runtime_error("Cannot spawn worker: " + std::string(std::strerror(rc)));
+            }
+            children.push_back(pid);
+        }
+    }
+
+    // Throw if a worker has already exited; called while workers should
+    // still be connecting
+    void checkRunning() {
+        for (auto it = children.begin(); it != children.end(); ++it) {
+            int status;
+            if (waitpid(*it, &status, WNOHANG) == *it) {
+                children.erase(it);
+                throw std::runtime_error("Worker exited before connecting (" + describe(status) + ")");
+            }
+        }
+    }
+
+    // Reap every worker once they have all finished
+    void wait() {
+        for (pid_t child : children) {
+            int status;
+            while (waitpid(child, &status, 0) < 0 && errno == EINTR) {}
+        }
+        children.clear();
+    }
+
+private:
+    std::vector<pid_t> children;
+
+    static std::string describe(int status) {
+        if (WIFEXITED(status)) return "exit status " + std::to_string(WEXITSTATUS(status));
+        if (WIFSIGNALED(status)) return "killed by signal " + std::to_string(WTERMSIG(status));
+        return "status " + std::to_string(status);
+    }
+};
+
+} // namespace
+
+std::vector<Genome> runCoordinator(
+    const ClusterConfig& config,
+    const std::function<void(std::size_t, const ClusterReport&)>& onGeneration) {
+    const std::size_t n = config.islands;
+    Listener listener(config.address);
+
+    WorkerProcesses children;
+    if (!config.workerProgram.empty()) {
+        children.spawn(config.workerProgram, listener.address(), n);
+    }
+
+    // A spawned worker that dies before connecting would otherwise leave
+    // accept() waiting forever
+    std::vector<Channel> workers;
+    for (std::size_t island = 0; island < n; island++) {
+        while (!listener.waitForConnection(CONNECT_POLL_MS)) {
+            children.checkRunning();
+        }
+        workers.push_back(listener.accept());
+        gp::ByteWriter hello;
+        hello.put_u32((std::uint32_t)island);
+        hello.put_u32((std::uint32_t)n);
+        hello.put_u64(config.seed);
+        hello.put_u32((std::uint32_t)config.generations);
+        hello.put_u32((std::uint32_t)config.migrationInterval);
+        hello.put_u32((std::uint32_t)config.migrants);
+        hello.put_u8((std::uint8_t)config.topology);
+        hello.put_u32((std::uint32_t)config.threadsPerIsland);
+        hello.put_u32((std::uint32_t)config.finalCount);
+        hello.put_u32((std::uint32_t)config.runs);
+        workers.back().send(HELLO, hello.bytes);
+    }
+
+    // Per generation, the island reports received so far
+    struct IslandReport {
+        ClusterEngine::EvolutionStats stats;
+        Genome best;
+        std::uint64_t bestScenarioSeed;
+    };
+    struct Pending {
+        std::size_t received = 0;
+        std::vector<IslandReport> islands;
+    };
+    std::map<std::size_t, Pending> generations;
+    std::size_t nextReport = 0;
+
+    // Aggregate in island order, exactly as gp::IslandModel does
+    auto aggregate = [&](const std::vector<IslandReport>& islands) {
+        auto [stats, i] = gp::aggregate_island_stats(islands.size(), [&](std::size_t island) -> const ClusterEngine::EvolutionStats& {
+            return islands[island].stats;
+        });
+        return ClusterReport{stats, islands[i].best, islands[i].bestScenarioSeed, i};
+    };
+    std::vector<std::vector<Genome>> finals(n);
+    std::size_t finished = 0;
+
+    std::vector<pollfd> fds(n);
+    for (std::size_t i = 0; i < n; i++) {
+        fds[i] = {workers[i].fd(), POLLIN, 0};
+    }
+
+    std::uint8_t type;
+    std::vector<std::uint8_t> payload;
+    while (finished < n) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("poll: " + std::string(std::strerror(errno)));
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            if (!workers[i].receive(type, payload)) {
+                throw std::runtime_error("Island " + std::to_string(i) + " disconnected before finishing");
+            }
+            gp::ByteReader in(payload);
+
+            if (type == STATS) {
+                std::size_t gen = in.get_u32();
+                auto stats = getStats(in);
+                std::uint64_t seed = in.get_u64();
+                Genome best = gp::read_genome<robot_gp::RobotNodeValue>(in);
+
+                Pending& pending = generations[gen];
+                pending.islands.resize(n);
+                pending.islands[i] = {stats, std::move(best), seed};
+                pending.received++;
+
+                // Report complete generations in order
+                for (auto it = generations.find(nextReport); it != generations.end() && it->second.received == n;
+                     it = generations.find(nextReport)) {
+                    if (onGeneration) onGeneration(nextReport, aggregate(it->second.islands));
+                    generations.erase(it);
+                    nextReport++;
+                }
+            } else if (type == MIGRANTS) {
+                for (std::size_t to : gp::migration_destinations(i, n, config.topology)) {
+                    workers[to].send(MIGRANTS, payload);
+                }
+            } else if (type == FINAL) {
+                finals[i] = getGenomes(in);
+                fds[i].fd = -1; // Nothing more to read from this worker
+                finished++;
+            } else {
+                throw std::runtime_error("Unexpected message type " + std::to_string(type));
+            }
+        }
+    }
+
+    children.wait();
+
+    std::vector<Genome> population;
+    for (auto& island : finals) {
+        for (auto& genome : island) {
+            population.push_back(std::move(genome));
+        }
+    }
+    return population;
+}
+
+void runWorker(const std::string& address, ClusterEngine::Parameters params) {
+    Channel coordinator = connectTo(address);
+
+    std::uint8_t type;
+    std::vector<std::uint8_t> payload;
+    if (!coordinator.receive(type, payload) || type != HELLO) {
+        throw std::runtime_error("Expected HELLO from the coordinator");
+    }
+    gp::ByteReader in(payload);
+    Hello hello{};
+    hello.island = in.get_u32();
+    hello.islands = in.get_u32();
+    hello.seed = in.get_u64();
+    hello.generations = in.get_u32();
+    hello.migrationInterval = in.get_u32();
+    hello.migrants = in.get_u32();
+    hello.topology = in.get_u8();
+    hello.threads = in.get_u32();
+    hello.finalCount = in.get_u32();
+    hello.runs = in.get_u32();
+    const auto topology = (gp::MigrationTopology)hello.topology;
+
+    // Seeds and elitism as in gp::IslandModel; the initial trees as main's threaded islands
+    params.seed = gp::derive_seed(hello.seed, gp::streams::ISLAND, hello.island);
+    params.generations = hello.generations;
+    params.num_threads = hello.threads;
+    params.elitism = std::max<std::size_t>(params.elitism, hello.migrants);
+    ClusterEngine engine(params, robot_gp::FitnessEvaluator(HEIGHT, WIDTH, (int)hello.runs));
+    gp::Rng rng(gp::derive_seed(hello.seed, gp::streams::TREE_GENERATOR, hello.island + 1));
+    robot_gp::TreeGenerator generator(rng);
+    engine.initialize_population([&] { return generator.generate_tree(params.max_depth); });
+
+    const auto from = gp::migration_sources(hello.island, hello.islands, topology);
+    std::map<std::pair<std::size_t, std::size_t>, std::vector<Genome>> arrived; // (generation, source) -> batch
+
+    for (std::size_t gen = 0; gen < hello.generations; gen++) {
+        auto stats = engine.evolve_with_stats();
+
+        gp::ByteWriter report;
+        report.put_u32((std::uint32_t)gen);
+        putStats(report, stats);
+        report.put_u64(engine.get_best_scenario_seed());
+        gp::write_genome(report, engine.get_best());
+        coordinator.send(STATS, report.bytes);
+
+        if (!gp::migrates_after(gen, hello.generations, hello.islands, hello.migrationInterval)) continue;
+
+        gp::ByteWriter batch;
+        batch.put_u32(hello.island);
+        batch.put_u32((std::uint32_t)gen);
+        putGenomes(batch, engine.emigrants(hello.migrants));
+        coordinator.send(MIGRANTS, batch.bytes);
+
+        // Batches can arrive early from faster islands; keep them until their generation
+        auto complete = [&] {
+            for (std::size_t source : from) {
+                if (!arrived.count({gen, source})) return false;
+            }
+            return true;
+        };
+        while (!complete()) {
+            if (!coordinator.receive(type, payload) || type != MIGRANTS) {
+                throw std::runtime_error("Expected MIGRANTS from the coordinator");
+            }
+            gp::ByteReader batchIn(payload);
+            std::size_t source = batchIn.get_u32();
+            std::size_t batchGen = batchIn.get_u32();
+            arrived[{batchGen, source}] = getGenomes(batchIn);
+        }
+
+        std::vector<Genome> arrivals;
+        for (std::size_t source : from) {
+            auto node = arrived.extract({gen, source});
+            for (auto& genome : node.mapped()) {
+                arrivals.push_back(std::move(genome));
+            }
+        }
+        engine.immigrate(std::move(arrivals));
+    }
+
+    std::vector<Genome> population = engine.ranked_population();
+    population.resize(std::min<std::size_t>(hello.finalCount, population.size()));
+    gp::ByteWriter result;
+    putGenomes(result, population);
+    coordinator.send(FINAL, result.bytes);
+}
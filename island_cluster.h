@@ -0,0 +1,57 @@
+#ifndef ISLAND_CLUSTER_H
+#define ISLAND_CLUSTER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "gp_island.hpp"
+#include "robot_gp.hpp"
+
+// Island model spread over processes.
+//
+// One coordinator accepts one connection per island worker, assigns island
+// numbers in connection order and relays migrant batches between workers
+// along the topology. Workers evolve a GPEngine each and report every
+// generation. Islands, seeds and migration follow gp::IslandModel exactly,
+// so a run gives the same results as the threaded model with the same
+// parameters.
+
+using ClusterEngine = gp::GPEngine<robot_gp::RobotNodeValue, robot_gp::FitnessEvaluator>;
+
+struct ClusterConfig {
+    std::string address;               // unix:PATH or tcp:HOST:PORT
+    std::size_t islands = 2;
+    std::size_t generations = 1;
+    std::size_t migrationInterval = 5;
+    std::size_t migrants = 2;
+    gp::MigrationTopology topology = gp::MigrationTopology::RING;
+    std::uint64_t seed = 0;
+    std::size_t threadsPerIsland = 1;
+    int runs = RUNS;                   // Runs per scenario in every fitness
+    std::size_t finalCount = 0;        // Best individuals each worker returns at the end, scored and ranked
+    std::string workerProgram;         // Spawn the workers from this executable; empty waits for external ones
+};
+
+// One generation over all islands
+struct ClusterReport {
+    ClusterEngine::EvolutionStats stats; // Best over islands, mean of island averages, summed counters
+    ClusterEngine::GenomeType best;
+    std::uint64_t bestScenarioSeed;
+    std::size_t bestIsland;
+};
+
+// Run the coordinator until every worker has finished. onGeneration is
+// called in generation order once all islands have reported it. Returns
+// the final individuals of every island, island by island.
+std::vector<ClusterEngine::GenomeType> runCoordinator(
+    const ClusterConfig& config,
+    const std::function<void(std::size_t, const ClusterReport&)>& onGeneration);
+
+// Connect to a coordinator and evolve the island it assigns. params supplies
+// everything but the seed, generation count and thread count, which come from
+// the coordinator.
+void runWorker(const std::string& address, ClusterEngine::Parameters params);
+
+#endif // ISLAND_CLUSTER_H
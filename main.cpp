@@ -5,17 +5,24 @@
 #include <filesystem>
 #include <chrono>
 #include <random>
+#include <cstring>
+#include <thread>
+#include <memory>
 
 #include "environment.h"
 #include "robot.h"
 #include "constants.h"
 #include "gp_engine.hpp"
 #include "robot_gp.hpp"
+#include "gp_island.hpp"
+#include "island_cluster.h"
+#include "image_writer.h"
+#include "checkpoint.h"
+#include "gp_serialize.hpp"
+#include "gp_archive.hpp"
 
-// Image tracking globals (kept for compatibility)
+// Frame buffer for the best individual's track
 unsigned char best_track[HEIGHT][WIDTH][3];
-int robot_track[HEIGHT][WIDTH];
-int ball_track[HEIGHT][WIDTH];
 
 // File handling helper functions
 int countExistingFiles(const std::string& baseName, const std::string& extension) {
@@ -31,39 +38,23 @@ int countExistingFiles(const std::string& baseName, const std::string& extension
     return count;
 }
 
-void saveBestTrack(int generation) {
-    std::cout << "\n\t\tSaving visualization...\n";
-    std::ostringstream filename_ss, command_ss;
-    filename_ss << "paths/caminho" << std::setfill('0') << std::setw(3) << generation << ".ppm";
-    
-    std::ofstream track_file(filename_ss.str(), std::ios::out | std::ios::binary);
-    if (!track_file) {
-        std::cerr << "Failed to create track file: " << filename_ss.str() << "\n";
-        return;
-    }
+// Hand the frame to the writer; with a background writer this only copies
+// the pixels, so the generation loop never waits on encoding or disk
+void saveBestTrack(int generation, AsyncFrameWriter* writer, ImageFormat format) {
+    gp::trace::Span span("saveBestTrack", "io", "generation", generation);
+    std::ostringstream filename_ss;
+    filename_ss << "paths/caminho" << std::setfill('0') << std::setw(3) << generation
+                << (format == ImageFormat::PNG ? ".png" : ".ppm");
 
-    // Write PPM header
-    track_file << "P3\n200 200\n255\n";
-
-    // Write pixel data
-    for (int lin = 0; lin < HEIGHT; lin++) {
-        for (int col = 0; col < WIDTH; col++) {
-            track_file << (int)best_track[lin][col][0] << " "
-                      << (int)best_track[lin][col][1] << " "
-                      << (int)best_track[lin][col][2] << "   ";
-        }
-        track_file << "\n";
+    if (writer) {
+        writer->submit(filename_ss.str(), &best_track[0][0][0], WIDTH, HEIGHT);
+    } else {
+        writeImage(filename_ss.str(), &best_track[0][0][0], WIDTH, HEIGHT, format);
     }
-    track_file.close();
-
-    // Convert to GIF and cleanup
-    command_ss << "magick " << filename_ss.str() << " paths/caminho" 
-               << std::setfill('0') << std::setw(3) 
-               << generation << ".gif && rm " << filename_ss.str();
-    system(command_ss.str().c_str());
 }
 
-void updateBestTrack(const Environment& env, const Robot& robot, const ball_data& ball) {
+// Draw the replayed trajectory of the generation's best over the arena
+void updateBestTrack(const Environment& env, const robot_gp::Trajectory& trajectory) {
     // Clear track
     std::memset(best_track, 0, sizeof(best_track));
     
@@ -79,51 +70,67 @@ void updateBestTrack(const Environment& env, const Robot& robot, const ball_data
         }
     }
 
-    // Draw robot path
-    for (int lin = 0; lin < HEIGHT; lin++) {
-        for (int col = 0; col < WIDTH; col++) {
-            if (robot_track[lin][col] > 0) {
-                if (robot_track[lin][col] < 20) {
-                    best_track[lin][col][0] = 255;
-                    best_track[lin][col][1] = 255;
-                    best_track[lin][col][2] = 0;
-                } else {
-                    best_track[lin][col][0] = 255;
-                    best_track[lin][col][1] = 0;
-                    best_track[lin][col][2] = 0;
-                }
-            }
+    auto paint = [](float lin, float col, unsigned char r, unsigned char g, unsigned char b) {
+        int l = (int)lin, c = (int)col;
+        if (l < 0 || l >= HEIGHT || c < 0 || c >= WIDTH) return;
+        best_track[l][c][0] = r;
+        best_track[l][c][1] = g;
+        best_track[l][c][2] = b;
+    };
+
+    // Draw robot path: first steps yellow, the rest red
+    for (const auto& sample : trajectory.samples) {
+        if (sample.step < 20) {
+            paint(sample.lin, sample.col, 255, 255, 0);
+        } else {
+            paint(sample.lin, sample.col, 255, 0, 0);
         }
     }
 
     // Draw ball path
-    for (int lin = 0; lin < HEIGHT; lin++) {
-        for (int col = 0; col < WIDTH; col++) {
-            if (ball_track[lin][col] == 1) {
-                best_track[lin][col][0] = 0;
-                best_track[lin][col][1] = 255;
-                best_track[lin][col][2] = 0;
-            }
-        }
+    for (const auto& sample : trajectory.samples) {
+        paint(sample.ball_lin, sample.ball_col, 0, 255, 0);
     }
 }
 
-int main() {
-    // Initialize random number generator
-    std::random_device rd;
-    auto seed = rd();
-    std::mt19937 rng(seed);
-
-    // Create environment and robot
-    Environment env;
-    Robot robot(env);
-    ball_data ball{};
+// Per-generation profile side file (builds with WALLER_PROFILE): phase times
+// in milliseconds, then counters. Phase times are summed over the threads
+// that recorded them: evaluation over the engine threads, simulation over
+// the threads inside fitness calls. generation_ms is wall time.
+void writeProfileHeader(std::ostream& out) {
+    out << "generation,generation_ms";
+    for (const char* phase : gp::profile::PHASE_NAMES) {
+        out << "," << phase << "_ms";
+    }
+    out << ",busiest_thread_simulation_ms,threads";
+    for (const char* counter : gp::profile::COUNTER_NAMES) {
+        out << "," << counter;
+    }
+    out << ",steps_per_second,pool_allocations,pool_deallocations,system_allocations\n";
+}
 
-    // Initialize GP engine components
-    robot_gp::TreeGenerator tree_generator(rng);
-    robot_gp::FitnessEvaluator fitness_evaluator(env, robot, ball);
+void writeProfileRow(std::ostream& out, int generation, double generationMs,
+                     const gp::profile::Interval& interval, const gp::AllocationCounters& allocations) {
+    using gp::profile::Phase;
+    const gp::profile::Totals& totals = interval.totals;
+    out << generation << "," << generationMs;
+    for (std::size_t phase = 0; phase < gp::profile::PHASES; ++phase) {
+        out << "," << totals.milliseconds(static_cast<Phase>(phase));
+    }
+    out << "," << interval.busiest_simulation_ms << "," << interval.threads;
+    for (std::uint64_t count : totals.counts) {
+        out << "," << count;
+    }
+    const double evaluationSeconds = totals.milliseconds(Phase::EVALUATION) / 1000.0;
+    const double steps = static_cast<double>(totals.count(gp::profile::Counter::STEPS));
+    out << "," << (evaluationSeconds > 0 ? steps / evaluationSeconds : 0.0)
+        << "," << allocations.pool_allocations << "," << allocations.pool_deallocations
+        << "," << allocations.system_allocations << "\n";
+    out.flush();
+}
 
-    // Configure GP parameters
+// GP parameters shared by single runs, islands and cluster workers
+gp::GPEngine<robot_gp::RobotNodeValue, robot_gp::FitnessEvaluator>::Parameters makeParameters() {
     gp::GPEngine<robot_gp::RobotNodeValue, robot_gp::FitnessEvaluator>::Parameters params;
     params.population_size = POPULATION;
     params.generations = GENS;
@@ -132,65 +139,439 @@ int main() {
     params.tournament_size = 5;
     params.max_depth = 17;      // Equivalent to original LIMIT
     params.max_nodes = 100;     // New parameter for safety
+    params.num_threads = std::max(1u, std::thread::hardware_concurrency());
+    params.cache_capacity = 4 * POPULATION;
+    return params;
+}
+
+int main(int argc, char* argv[]) {
+    // One run seed; every random stream (engine, initial trees, scenarios)
+    // is derived from it. Pass --seed N to reproduce a run.
+    // Frames go to paths/ as PNG by default, written on a background thread;
+    // --frames none skips visualization, --sync-frames writes inline.
+    // --steady-state replaces individuals in place instead of whole generations.
+    // --islands N runs N populations on their own threads with ring migration
+    // (--topology all for all-to-all). --coordinator ADDRESS runs the islands
+    // as separate processes connected over unix:PATH or tcp:HOST:PORT; it
+    // spawns them unless --no-spawn is given, in which case they are started
+    // by hand with --worker ADDRESS.
+    // --runs N averages each fitness over N runs (start positions) per scenario.
+    // --generations N overrides GENS, e.g. for short profiling runs.
+    // --trace FILE records a Chrome trace_event JSON of this process
+    // (builds with WALLER_TRACE).
+    // Single-population runs save a checkpoint every generation to
+    // data/dataN.ckpt (--checkpoint FILE to change it, --checkpoint-every N,
+    // 0 for none). --resume FILE continues such a run where its checkpoint
+    // left off, with the seed and settings it was started with, and gives
+    // the same results as if it had never stopped.
+    // --initial-population FILE starts a single-population run from an
+    // archive robots/populationNNN.gpa saved by an earlier run, best first;
+    // generated trees fill any places it leaves.
+    std::uint64_t seed = 0;
+    std::string frames = "png";
+    bool sync_frames = false;
+    bool steady_state = false;
+    std::size_t islands = 1;
+    gp::MigrationTopology topology = gp::MigrationTopology::RING;
+    std::string coordinator_address;
+    std::string worker_address;
+    bool spawn_workers = true;
+    int runs = RUNS;
+    std::size_t generations = GENS;
+    bool generations_given = false;
+    std::string trace_path;
+    std::string checkpoint_path;
+    std::size_t checkpoint_every = 1;
+    std::string resume_path;
+    std::string initial_population_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoull(argv[++i]);
+        } else if (arg == "--frames" && i + 1 < argc &&
+                   (std::string(argv[i + 1]) == "png" || std::string(argv[i + 1]) == "ppm" ||
+                    std::string(argv[i + 1]) == "none")) {
+            frames = argv[++i];
+        } else if (arg == "--sync-frames") {
+            sync_frames = true;
+        } else if (arg == "--steady-state") {
+            steady_state = true;
+        } else if (arg == "--islands" && i + 1 < argc) {
+            islands = std::max<std::size_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "--topology" && i + 1 < argc &&
+                   (std::string(argv[i + 1]) == "ring" || std::string(argv[i + 1]) == "all")) {
+            topology = std::string(argv[++i]) == "ring" ? gp::MigrationTopology::RING : gp::MigrationTopology::ALL_TO_ALL;
+        } else if (arg == "--coordinator" && i + 1 < argc) {
+            coordinator_address = argv[++i];
+        } else if (arg == "--no-spawn") {
+            spawn_workers = false;
+        } else if (arg == "--worker" && i + 1 < argc) {
+            worker_address = argv[++i];
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--generations" && i + 1 < argc) {
+            generations = std::max<std::size_t>(1, std::stoul(argv[++i]));
+            generations_given = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (arg == "--checkpoint-every" && i + 1 < argc) {
+            checkpoint_every = std::stoul(argv[++i]);
+        } else if (arg == "--resume" && i + 1 < argc) {
+            resume_path = argv[++i];
+        } else if (arg == "--initial-population" && i + 1 < argc) {
+            initial_population_path = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--seed N] [--frames png|ppm|none] [--sync-frames] [--steady-state] [--islands N]"
+                      << " [--topology ring|all] [--coordinator ADDRESS [--no-spawn]] [--worker ADDRESS] [--runs N] [--generations N] [--trace FILE]"
+                      << " [--checkpoint FILE] [--checkpoint-every N] [--resume FILE] [--initial-population FILE]\n";
+            return 1;
+        }
+    }
+
+    // Spans are recorded from here on; spawned workers are not traced
+    if (!trace_path.empty()) {
+        if constexpr (gp::trace::ENABLED) {
+            gp::trace::start();
+            gp::trace::name_thread("main");
+        } else {
+            std::cerr << "--trace needs a build with WALLER_TRACE; no trace will be written\n";
+        }
+    }
+    auto write_trace = [&] {
+        if (gp::trace::recording() && !gp::trace::write(trace_path)) {
+            std::cerr << "Failed to write trace " << trace_path << "\n";
+        }
+    };
+
+    if (!worker_address.empty()) {
+        try {
+            runWorker(worker_address, makeParameters());
+        } catch (const std::exception& e) {
+            std::cerr << "Worker failed: " << e.what() << "\n";
+            return 1;
+        }
+        write_trace();
+        return 0;
+    }
+
+    // A resumed run keeps the settings results depend on; --generations may
+    // extend or shorten it
+    if ((islands > 1 || !coordinator_address.empty()) && !checkpoint_path.empty()) {
+        std::cerr << "Checkpoints cover single-population runs; none will be written\n";
+    }
+    RunCheckpoint resume;
+    if (!resume_path.empty()) {
+        if (islands > 1 || !coordinator_address.empty()) {
+            std::cerr << "--resume applies to single-population runs only\n";
+            return 1;
+        }
+        try {
+            resume = loadCheckpoint(resume_path);
+        } catch (const std::exception& e) {
+            std::cerr << "Cannot resume: " << e.what() << "\n";
+            return 1;
+        }
+        seed = resume.seed;
+        runs = resume.runs;
+        steady_state = resume.steadyState;
+        if (!generations_given) generations = resume.generations;
+        if (checkpoint_path.empty()) checkpoint_path = resume_path;
+    }
+    if (!initial_population_path.empty() && (islands > 1 || !coordinator_address.empty() || !resume_path.empty())) {
+        std::cerr << "--initial-population applies to new single-population runs only\n";
+        return 1;
+    }
 
-    // Create GP engine
-    gp::GPEngine<robot_gp::RobotNodeValue, robot_gp::FitnessEvaluator> gp_engine(params, fitness_evaluator);
+    if (seed == 0) {
+        std::random_device rd;
+        seed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+    }
+    std::cout << "Seed: " << seed << "\n";
+    gp::Rng rng(gp::derive_seed(seed, gp::streams::TREE_GENERATOR));
+
+    // Environment used for drawing; evaluation runs in the evaluators' own sandboxes
+    Environment env;
+    env.initialize();
 
-    // Setup data logging
-    auto data_file_count = countExistingFiles("data/data", ".txt");
-    std::ofstream data_file("data/data" + std::to_string(data_file_count) + ".txt");
+    ImageFormat frame_format = frames == "ppm" ? ImageFormat::PPM : ImageFormat::PNG;
+    std::unique_ptr<AsyncFrameWriter> frame_writer;
+    if (frames != "none" && !sync_frames) {
+        frame_writer = std::make_unique<AsyncFrameWriter>(frame_format);
+    }
+
+    // Initialize GP engine components
+    robot_gp::TreeGenerator tree_generator(rng);
+    robot_gp::FitnessEvaluator fitness_evaluator(HEIGHT, WIDTH, runs);
+
+    // Configure GP parameters
+    auto params = makeParameters();
+    params.seed = seed;
+    params.generations = generations;
+    if (steady_state) {
+        params.mode = gp::EvolutionMode::STEADY_STATE;
+    }
+    if ((islands > 1 || !coordinator_address.empty()) && steady_state) {
+        std::cerr << "Islands and --steady-state cannot be combined\n";
+        return 1;
+    }
+
+    // Setup data logging; a resumed run drops the rows written after its
+    // checkpoint and appends from there
+    std::string data_stem;
+    std::ofstream data_file;
+    if (!resume_path.empty()) {
+        data_stem = resume.dataFile.substr(0, resume.dataFile.rfind(".txt"));
+        std::error_code error;
+        std::filesystem::resize_file(resume.dataFile, resume.dataFileSize, error);
+        if (!error) data_file.open(resume.dataFile, std::ios::app);
+    } else {
+        data_stem = "data/data" + std::to_string(countExistingFiles("data/data", ".txt"));
+        data_file.open(data_stem + ".txt");
+        if (data_file) {
+            data_file << "ROBO SEGUIDOR v2.0\n";
+            data_file << "GERACAO\tMEDIA\t\tMAIOR\n";
+        }
+    }
     if (!data_file) {
         std::cerr << "Failed to create data file\n";
         return 1;
     }
+    if (checkpoint_path.empty()) checkpoint_path = data_stem + ".ckpt";
 
-    // Write header
-    data_file << "ROBO SEGUIDOR v2.0\n";
-    data_file << "GERACAO\tMEDIA\t\tMAIOR\n";
+    // Phase timings next to the data file, when compiled in; resumed like
+    // the data file, or started afresh if the checkpoint has none
+    const std::string profile_path = data_stem + "_profile.csv";
+    std::ofstream profile_file;
+    if constexpr (gp::profile::ENABLED) {
+        std::error_code error;
+        if (!resume_path.empty() && resume.profileFileSize > 0) {
+            std::filesystem::resize_file(profile_path, resume.profileFileSize, error);
+        }
+        if (!resume_path.empty() && resume.profileFileSize > 0 && !error) {
+            profile_file.open(profile_path, std::ios::app);
+        } else {
+            profile_file.open(profile_path);
+            writeProfileHeader(profile_file);
+        }
+    }
 
     // Record start time
     auto start_time = std::chrono::system_clock::now();
 
-    std::cout << "\nInitializing population...\n";
-    gp_engine.initialize_population([&]() {
-        return tree_generator.generate_tree(params.max_depth);
-    });
+    using Engine = gp::GPEngine<robot_gp::RobotNodeValue, robot_gp::FitnessEvaluator>;
 
-    // Main evolution loop
-    std::cout << "\nStarting evolution...\n";
-    for (int gen = 0; gen < params.generations; gen++) {
+    // Profile row for everything since the previous generation's row,
+    // its report included; the generation time is wall clock, and the
+    // first one also covers building the initial population
+    auto generation_start = std::chrono::steady_clock::now();
+    auto report_profile = [&](int gen, const gp::AllocationCounters& allocations) {
+        if constexpr (gp::profile::ENABLED) {
+            auto now = std::chrono::steady_clock::now();
+            double generation_ms = std::chrono::duration<double, std::milli>(now - generation_start).count();
+            writeProfileRow(profile_file, gen, generation_ms, gp::profile::collect(), allocations);
+            generation_start = now;
+        }
+    };
+
+    // Log one generation and draw its best individual, replayed under the
+    // scenario it was scored on
+    auto report_generation = [&](int gen, const Engine::EvolutionStats& stats,
+                                 const Engine::GenomeType& best, std::uint64_t best_scenario_seed) {
         std::cout << "\nGeneration " << gen << " -> ";
-        
-        // Evolve one generation
-        auto [best_fitness, avg_fitness] = gp_engine.evolve_with_stats();
-        
-        // Update visualization for best individual
-        updateBestTrack(env, robot, ball);
-        saveBestTrack(gen);
+
+        if (frames != "none") {
+            gp::profile::ScopedPhase phase(gp::profile::Phase::IMAGE_OUTPUT);
+            auto trajectory = fitness_evaluator.replay(best, best_scenario_seed);
+            updateBestTrack(env, trajectory);
+            saveBestTrack(gen, frame_writer.get(), frame_format);
+        }
 
         // Log progress
-        std::cout << "\nAverage Fitness: " << avg_fitness 
-                  << "\nBest Fitness: " << best_fitness << "\n";
-        
-        data_file << gen << "\t" << avg_fitness << "\t" << best_fitness << "\n";
-        data_file.flush();
-    }
-
-    // Save final population
-    std::cout << "\nSaving final population...\n";
-    auto robot_file_count = countExistingFiles("robots/rb", "tr.txt");
-    for (int i = 0; i < 100 && i < params.population_size; i++) {
-        std::string filename = "robots/rb" + 
-            std::to_string((robot_file_count + i) % 1000) + "tr.txt";
-            
-        std::ofstream robot_file(filename);
-        if (robot_file) {
-            // Save in compatible format
-            robot_file << gp_engine.get_individual(i).to_string() << "\n";
-            robot_file << "LENGTH = " << gp_engine.get_individual(i).size() << "\n";
-            robot_file << "FITNESS = " << gp_engine.get_individual(i).fitness << "\n";
+        {
+            gp::profile::ScopedPhase phase(gp::profile::Phase::LOGGING);
+            std::cout << "\nAverage Fitness: " << stats.average_fitness
+                      << "\nBest Fitness: " << stats.best_fitness
+                      << "\nFitness cache: " << stats.cache_hits << " hits, "
+                      << stats.cache_misses << " misses"
+                      << "\nNode allocator: " << stats.allocations.pool_allocations << " allocations, "
+                      << stats.allocations.pool_deallocations << " frees, "
+                      << stats.allocations.system_allocations << " system allocations\n";
+
+            data_file << gen << "\t" << stats.average_fitness << "\t" << stats.best_fitness << "\n";
+            data_file.flush();
+        }
+        report_profile(gen, stats.allocations);
+    };
+
+    // The final population goes to one archive, robots/populationNNN.gpa
+    // (see gp_archive.hpp); add_individuals(archive) streams it in, each
+    // population scored and ranked by GPEngine::ranked_population()
+    auto save_population = [&](const auto& add_individuals) {
+        std::ostringstream path;
+        path << "robots/population" << std::setfill('0') << std::setw(3)
+             << countExistingFiles("robots/population", ".gpa") << ".gpa";
+        std::cout << "\nSaving final population to " << path.str() << "...\n";
+        try {
+            gp::ArchiveWriter<robot_gp::RobotNodeValue> archive(path.str());
+            add_individuals(archive);
+            archive.finish();
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to save the final population: " << e.what() << "\n";
+        }
+    };
+    auto lineage = [&](std::size_t island, std::size_t rank) {
+        return gp::ArchiveLineage{seed, (std::uint32_t)params.generations, (std::uint32_t)island, (std::uint32_t)rank};
+    };
+
+    if (!coordinator_address.empty()) {
+        // Each island is a worker process; the coordinator only relays and logs
+        ClusterConfig config;
+        config.address = coordinator_address;
+        config.islands = islands;
+        config.generations = params.generations;
+        config.topology = topology;
+        config.runs = runs;
+        config.seed = seed;
+        config.threadsPerIsland = std::max<std::size_t>(1, params.num_threads / islands);
+        config.finalCount = params.population_size;
+        if (spawn_workers) {
+            config.workerProgram = std::filesystem::read_symlink("/proc/self/exe").string();
         }
+
+        std::cout << "\nStarting " << islands << " island workers on " << coordinator_address << "...\n";
+        std::vector<Engine::GenomeType> final_population;
+        try {
+            final_population = runCoordinator(config, [&](std::size_t gen, const ClusterReport& report) {
+                report_generation((int)gen, report.stats, report.best, report.bestScenarioSeed);
+            });
+        } catch (const std::exception& e) {
+            std::cerr << "Coordinator failed: " << e.what() << "\n";
+            return 1;
+        }
+
+        // Island by island, finalCount each, ranked by the workers
+        save_population([&](auto& archive) {
+            for (std::size_t i = 0; i < final_population.size(); ++i) {
+                archive.add(final_population[i], lineage(i / config.finalCount, i % config.finalCount));
+            }
+        });
+    } else if (islands > 1) {
+        // Each island is a full population; threads are split between them
+        gp::IslandModel<robot_gp::RobotNodeValue, robot_gp::FitnessEvaluator>::Parameters island_params;
+        island_params.islands = islands;
+        island_params.seed = seed;
+        island_params.topology = topology;
+        island_params.island = params;
+        island_params.island.num_threads = std::max<std::size_t>(1, params.num_threads / islands);
+        gp::IslandModel<robot_gp::RobotNodeValue, robot_gp::FitnessEvaluator> model(island_params, fitness_evaluator);
+
+        std::cout << "\nInitializing " << islands << " island populations...\n";
+        std::vector<gp::Rng> island_rngs;
+        for (std::size_t i = 0; i < islands; ++i) {
+            island_rngs.emplace_back(gp::derive_seed(seed, gp::streams::TREE_GENERATOR, i + 1));
+        }
+        model.initialize_populations([&](std::size_t island) {
+            return robot_gp::TreeGenerator(island_rngs[island]).generate_tree(params.max_depth);
+        });
+
+        std::cout << "\nStarting evolution...\n";
+        model.run(params.generations, [&](std::size_t gen, const auto& report) {
+            report_generation((int)gen, report.stats, *report.best, report.best_scenario_seed);
+        });
+
+        save_population([&](auto& archive) {
+            for (std::size_t i = 0; i < islands; ++i) {
+                const auto ranked = model.island(i).ranked_population();
+                for (std::size_t rank = 0; rank < ranked.size(); ++rank) {
+                    archive.add(ranked[rank], lineage(i, rank));
+                }
+            }
+        });
+    } else {
+        Engine gp_engine(params, fitness_evaluator);
+
+        int first_generation = 0;
+        if (!resume_path.empty()) {
+            std::cout << "\nResuming " << resume.dataFile << " at generation " << resume.nextGeneration << "...\n";
+            try {
+                gp::ByteReader in(resume.engine);
+                gp_engine.restore_state(gp::read_engine_state<Engine>(in));
+            } catch (const std::exception& e) {
+                std::cerr << "Cannot resume: " << e.what() << "\n";
+                return 1;
+            }
+            first_generation = (int)resume.nextGeneration;
+        } else if (!initial_population_path.empty()) {
+            std::cout << "\nLoading initial population from " << initial_population_path << "...\n";
+            try {
+                gp::ArchiveReader archive(initial_population_path);
+                std::size_t next = 0;
+                gp_engine.initialize_population([&]() {
+                    if (next < archive.size()) return archive.genome<robot_gp::RobotNodeValue>(next++);
+                    return tree_generator.generate_tree(params.max_depth);
+                });
+            } catch (const std::exception& e) {
+                std::cerr << "Cannot load initial population: " << e.what() << "\n";
+                return 1;
+            }
+        } else {
+            std::cout << "\nInitializing population...\n";
+            gp_engine.initialize_population([&]() {
+                return tree_generator.generate_tree(params.max_depth);
+            });
+        }
+
+        // Checkpoint taken after generation next - 1 has been logged; a
+        // failure is reported but does not stop the run
+        auto save_checkpoint = [&](int next) {
+            gp::trace::Span span("checkpoint", "io", "generation", next);
+            gp::profile::ScopedPhase phase(gp::profile::Phase::LOGGING);
+            RunCheckpoint checkpoint;
+            checkpoint.seed = seed;
+            checkpoint.runs = runs;
+            checkpoint.steadyState = steady_state;
+            checkpoint.generations = params.generations;
+            checkpoint.nextGeneration = next;
+            checkpoint.dataFile = data_stem + ".txt";
+            try {
+                checkpoint.dataFileSize = std::filesystem::file_size(checkpoint.dataFile);
+                if (profile_file.is_open()) {
+                    checkpoint.profileFileSize = std::filesystem::file_size(profile_path);
+                }
+                gp::ByteWriter engine_state;
+                gp::write_engine_state<Engine>(engine_state, gp_engine.save_state());
+                checkpoint.engine = std::move(engine_state.bytes);
+                saveCheckpoint(checkpoint_path, checkpoint);
+            } catch (const std::exception& e) {
+                std::cerr << "Checkpoint failed: " << e.what() << "\n";
+            }
+        };
+
+        // Main evolution loop
+        std::cout << "\nStarting evolution...\n";
+        for (int gen = first_generation; gen < (int)params.generations; gen++) {
+            auto stats = gp_engine.evolve_with_stats();
+            report_generation(gen, stats, gp_engine.get_best(), gp_engine.get_best_scenario_seed());
+            const std::size_t done = gen + 1;
+            if (checkpoint_every > 0 && (done % checkpoint_every == 0 || done == params.generations)) {
+                save_checkpoint((int)done);
+            }
+        }
+
+        save_population([&](auto& archive) {
+            const auto ranked = gp_engine.ranked_population();
+            for (std::size_t rank = 0; rank < ranked.size(); ++rank) {
+                archive.add(ranked[rank], lineage(0, rank));
+            }
+        });
+    }
+
+    if (frame_writer) {
+        frame_writer->flush();
     }
+    write_trace();
 
     // Calculate and display runtime
     auto end_time = std::chrono::system_clock::now();
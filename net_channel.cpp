@@ -0,0 +1,236 @@
+#include "net_channel.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::uint32_t MAX_FRAME = 64u << 20;
+
+[[noreturn]] void fail(const std::string& what) {
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+struct Endpoint {
+    bool isUnix;
+    std::string path; // unix
+    std::string host; // tcp
+    std::string port;
+};
+
+Endpoint parse(const std::string& address) {
+    if (address.rfind("unix:", 0) == 0) {
+        return {true, address.substr(5), "", ""};
+    }
+    if (address.rfind("tcp:", 0) == 0) {
+        auto colon = address.rfind(':');
+        if (colon > 4) {
+            return {false, "", address.substr(4, colon - 4), address.substr(colon + 1)};
+        }
+    }
+    throw std::runtime_error("Bad address (expected unix:PATH or tcp:HOST:PORT): " + address);
+}
+
+sockaddr_un unixAddress(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Unix socket path too long: " + path);
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+addrinfo* resolve(const Endpoint& endpoint, bool passive) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    addrinfo* result = nullptr;
+    if (int rc = getaddrinfo(endpoint.host.c_str(), endpoint.port.c_str(), &hints, &result); rc != 0) {
+        throw std::runtime_error("Cannot resolve " + endpoint.host + ":" + endpoint.port + ": " + gai_strerror(rc));
+    }
+    return result;
+}
+
+// Small frames go out immediately instead of waiting for Nagle's timer
+void setNoDelay(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+void writeAll(int fd, const std::uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = ::send(fd, data, length, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fail("send");
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+}
+
+// False on a clean close before the first byte
+bool readAll(int fd, std::uint8_t* data, size_t length) {
+    size_t got = 0;
+    while (got < length) {
+        ssize_t n = ::recv(fd, data + got, length - got, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fail("recv");
+        }
+        if (n == 0) {
+            if (got == 0) return false;
+            throw std::runtime_error("Connection closed inside a frame");
+        }
+        got += (size_t)n;
+    }
+    return true;
+}
+
+} // namespace
+
+Channel::Channel(int fd) : socket(fd) {}
+
+Channel::~Channel() {
+    if (socket >= 0) ::close(socket);
+}
+
+Channel::Channel(Channel&& other) noexcept : socket(other.socket) {
+    other.socket = -1;
+}
+
+Channel& Channel::operator=(Channel&& other) noexcept {
+    if (this != &other) {
+        if (socket >= 0) ::close(socket);
+        socket = other.socket;
+        other.socket = -1;
+    }
+    return *this;
+}
+
+void Channel::send(std::uint8_t type, std::span<const std::uint8_t> payload) {
+    if (payload.size() > MAX_FRAME) {
+        throw std::runtime_error("Frame too large");
+    }
+    std::vector<std::uint8_t> frame(5 + payload.size());
+    const std::uint32_t length = (std::uint32_t)payload.size();
+    for (int i = 0; i < 4; i++) {
+        frame[i] = (std::uint8_t)(length >> (8 * i));
+    }
+    frame[4] = type;
+    std::memcpy(frame.data() + 5, payload.data(), payload.size());
+    writeAll(socket, frame.data(), frame.size());
+}
+
+bool Channel::receive(std::uint8_t& type, std::vector<std::uint8_t>& payload) {
+    std::uint8_t header[5];
+    if (!readAll(socket, header, sizeof(header))) return false;
+    std::uint32_t length = 0;
+    for (int i = 0; i < 4; i++) {
+        length |= (std::uint32_t)header[i] << (8 * i);
+    }
+    if (length > MAX_FRAME) {
+        throw std::runtime_error("Frame too large");
+    }
+    type = header[4];
+    payload.resize(length);
+    if (length > 0 && !readAll(socket, payload.data(), length)) {
+        throw std::runtime_error("Connection closed inside a frame");
+    }
+    return true;
+}
+
+Listener::Listener(const std::string& address) {
+    Endpoint endpoint = parse(address);
+    if (endpoint.isUnix) {
+        sockaddr_un addr = unixAddress(endpoint.path);
+        socket = Channel(::socket(AF_UNIX, SOCK_STREAM, 0));
+        if (socket.fd() < 0) fail("socket");
+        ::unlink(endpoint.path.c_str()); // Stale socket from an earlier run
+        if (::bind(socket.fd(), (sockaddr*)&addr, sizeof(addr)) < 0) fail("bind " + endpoint.path);
+        unixPath = endpoint.path;
+        bound = address;
+    } else {
+        addrinfo* info = resolve(endpoint, true);
+        socket = Channel(::socket(info->ai_family, info->ai_socktype, info->ai_protocol));
+        if (socket.fd() < 0) {
+            freeaddrinfo(info);
+            fail("socket");
+        }
+        int one = 1;
+        setsockopt(socket.fd(), SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        int rc = ::bind(socket.fd(), info->ai_addr, info->ai_addrlen);
+        freeaddrinfo(info);
+        if (rc < 0) fail("bind " + address);
+
+        sockaddr_storage local{};
+        socklen_t length = sizeof(local);
+        getsockname(socket.fd(), (sockaddr*)&local, &length);
+        int port = local.ss_family == AF_INET6 ? ntohs(((sockaddr_in6*)&local)->sin6_port)
+                                               : ntohs(((sockaddr_in*)&local)->sin_port);
+        bound = "tcp:" + endpoint.host + ":" + std::to_string(port);
+    }
+    if (::listen(socket.fd(), 64) < 0) fail("listen");
+}
+
+Listener::~Listener() {
+    if (!unixPath.empty()) ::unlink(unixPath.c_str());
+}
+
+bool Listener::waitForConnection(int timeoutMs) {
+    pollfd fd{socket.fd(), POLLIN, 0};
+    int rc = ::poll(&fd, 1, timeoutMs);
+    if (rc < 0) {
+        if (errno == EINTR) return false;
+        fail("poll");
+    }
+    return rc > 0;
+}
+
+Channel Listener::accept() {
+    for (;;) {
+        int fd = ::accept(socket.fd(), nullptr, nullptr);
+        if (fd >= 0) {
+            if (unixPath.empty()) setNoDelay(fd);
+            return Channel(fd);
+        }
+        if (errno != EINTR) fail("accept");
+    }
+}
+
+Channel connectTo(const std::string& address) {
+    Endpoint endpoint = parse(address);
+    if (endpoint.isUnix) {
+        sockaddr_un addr = unixAddress(endpoint.path);
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) fail("socket");
+        Channel channel(fd);
+        if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) fail("connect " + endpoint.path);
+        return channel;
+    }
+
+    addrinfo* info = resolve(endpoint, false);
+    int fd = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(info);
+        fail("socket");
+    }
+    Channel channel(fd);
+    int rc = ::connect(fd, info->ai_addr, info->ai_addrlen);
+    freeaddrinfo(info);
+    if (rc < 0) fail("connect " + address);
+    setNoDelay(fd);
+    return channel;
+}
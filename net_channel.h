@@ -0,0 +1,63 @@
+#ifndef NET_CHANNEL_H
+#define NET_CHANNEL_H
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Framed message sockets between local processes.
+//
+// Addresses are "unix:/path/to.sock" (Unix domain socket) or
+// "tcp:HOST:PORT" (TCP, meant for loopback). A frame is a little-endian
+// u32 payload length, a u8 message type, then the payload. Errors throw
+// std::runtime_error.
+
+class Channel {
+public:
+    explicit Channel(int fd = -1);
+    ~Channel();
+
+    Channel(Channel&& other) noexcept;
+    Channel& operator=(Channel&& other) noexcept;
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    void send(std::uint8_t type, std::span<const std::uint8_t> payload);
+
+    // Block for the next frame; false once the peer has closed the connection
+    bool receive(std::uint8_t& type, std::vector<std::uint8_t>& payload);
+
+    int fd() const { return socket; }
+
+private:
+    int socket;
+};
+
+class Listener {
+public:
+    // Bind and listen; "tcp:HOST:0" picks a free port
+    explicit Listener(const std::string& address);
+    ~Listener();
+
+    Listener(const Listener&) = delete;
+    Listener& operator=(const Listener&) = delete;
+
+    // True once a connection is waiting for accept(), false if none came
+    // within timeoutMs or the wait was interrupted
+    bool waitForConnection(int timeoutMs);
+
+    Channel accept();
+
+    // Address clients should connect to, with the port resolved
+    const std::string& address() const { return bound; }
+
+private:
+    Channel socket; // Owns the descriptor, so a constructor that throws closes it
+    std::string bound;
+    std::string unixPath; // Removed again on destruction
+};
+
+Channel connectTo(const std::string& address);
+
+#endif // NET_CHANNEL_H
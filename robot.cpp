@@ -1,24 +1,25 @@
 #include "robot.h"
+#include "direction.h"
+#include "robot_commands.hpp"
 #include <cmath>
 #include <cstdlib>
-#include <ctime>
 
 #define ANGLE 5
 #define VIEW_ANGLE 30
 
 Robot::Robot(Environment& environment) : env(environment) {}
 
-void Robot::initialize() {
+void Robot::initialize(gp::Rng& rng) {
     do {
-        dir = ANGLE * (rand() % (360 / ANGLE));
-        col = (int)(rand() % (WIDTH-2)) + 1;
-        lin = (int)(rand() % (HEIGHT-2)) + 1;
+        dir = ANGLE * rng.uniform(0, (360 / ANGLE) - 1);
+        col = rng.uniform(1, env.width()-2);
+        lin = rng.uniform(1, env.height()-2);
 
         if (env.getCell((int)lin, (int)col)) {
-            if (rand() % 2) {
-                col = (int)(rand() % (WIDTH-2)) + 1;
+            if (rng.below(2)) {
+                col = rng.uniform(1, env.width()-2);
             } else {
-                lin = (int)(rand() % (HEIGHT-2)) + 1;
+                lin = rng.uniform(1, env.height()-2);
             }
         }
     } while (env.getCell((int)lin, (int)col));
@@ -26,10 +27,9 @@ void Robot::initialize() {
     env.setCell((int)lin, (int)col, 1);
 }
 
-void Robot::walkFront() {
-    double angle = dir;
-    double testlin = lin - sin((M_PI * angle) / 180);
-    double testcol = col + cos((M_PI * angle) / 180);
+void Robot::tryStep(Environment& env, double& lin, double& col, const StepVector& step) {
+    double testlin = lin + step.dlin;
+    double testcol = col + step.dcol;
 
     if (!env.getCell((int)testlin, (int)testcol)) {
         env.setCell((int)lin, (int)col, 0);
@@ -39,17 +39,12 @@ void Robot::walkFront() {
     }
 }
 
-void Robot::walkBack() {
-    double angle = dir + 180;
-    double testlin = lin - sin((M_PI * angle) / 180);
-    double testcol = col + cos((M_PI * angle) / 180);
+void Robot::walkFront() {
+    tryStep(env, lin, col, DIRECTIONS[dir]);
+}
 
-    if (!env.getCell((int)testlin, (int)testcol)) {
-        env.setCell((int)lin, (int)col, 0);
-        lin = testlin;
-        col = testcol;
-        env.setCell((int)lin, (int)col, 1);
-    }
+void Robot::walkBack() {
+    tryStep(env, lin, col, stepFor(dir + 180));
 }
 
 void Robot::turnLeft() {
@@ -89,7 +84,7 @@ bool isAngleInRange(double angle1, double angle2, double range) {
     return abs((int)(angle1 - angle2)) <= range;
 }
 
-void Robot::align(double ballLin, double ballCol) {
+int Robot::alignedHeading(const Environment& env, double lin, double col, int dir, double ballLin, double ballCol) {
     double angle = calculateAngleBetweenPoints(lin, col, ballLin, ballCol);
     
     if (isAngleInRange(angle, dir, VIEW_ANGLE)) {
@@ -98,13 +93,10 @@ void Robot::align(double ballLin, double ballCol) {
             dir = angle;
         }
     }
+    return dir;
 }
 
-bool Robot::isNearWall() const {
-    return !env.isPathClear(lin, col, dir, 2);
-}
-
-bool Robot::canSeeBall(double ballLin, double ballCol) const {
+bool Robot::seesBall(const Environment& env, double lin, double col, int dir, double ballLin, double ballCol) {
     double angle = calculateAngleBetweenPoints(lin, col, ballLin, ballCol);
 
     if ((int)(angle - dir) > VIEW_ANGLE || (int)(angle - dir) < -VIEW_ANGLE) {
@@ -113,4 +105,59 @@ bool Robot::canSeeBall(double ballLin, double ballCol) const {
         }
     }
     return true;
-}
\ No newline at end of file
+}
+
+void Robot::align(double ballLin, double ballCol) {
+    dir = alignedHeading(env, lin, col, dir, ballLin, ballCol);
+}
+
+bool Robot::isNearWall() const {
+    return !env.isPathClear(lin, col, dir, 2);
+}
+
+bool Robot::canSeeBall(double ballLin, double ballCol) const {
+    return seesBall(env, lin, col, dir, ballLin, ballCol);
+}
+
+double placeRun(Environment& env, Robot& robot, ball_data& ball, std::uint64_t scenarioSeed, int runIndex) {
+    gp::Rng rng(gp::derive_seed(scenarioSeed, gp::streams::RUN, runIndex));
+
+    // Undo the previous run's writes, then place robot and ball
+    env.reset();
+    robot.initialize(rng);
+
+    do {
+        ball.col = rng.uniform(1, env.width()-2);
+        ball.lin = rng.uniform(1, env.height()-2);
+    } while (env.getCell(ball.lin, ball.col));
+    env.setCell(ball.lin, ball.col, 1);
+
+    return std::sqrt(
+        std::pow(ball.lin - robot.getLine(), 2) +
+        std::pow(ball.col - robot.getColumn(), 2)
+    );
+}
+
+void kickBall(Environment& env, ball_data& ball, int heading) {
+    ball.dir = heading;
+
+    // Calculate next position
+    double testlin = ball.lin + (2 * DIRECTIONS[ball.dir].dlin);
+    double testcol = ball.col + (2 * DIRECTIONS[ball.dir].dcol);
+
+    // Check bounds and adjust position
+    if (testlin < 0 || testlin > env.height()-1 || 
+        testcol < 0 || testcol > env.width()-1 ||
+        env.getCell((int)testlin, (int)testcol)) {
+        // If hitting wall or obstacle, bounce
+        ball.dir = (ball.dir + 180) % 360;
+        testlin = ball.lin + (2 * DIRECTIONS[ball.dir].dlin);
+        testcol = ball.col + (2 * DIRECTIONS[ball.dir].dcol);
+    }
+
+    // Update ball position
+    env.setCell((int)ball.lin, (int)ball.col, 0);
+    ball.lin = testlin;
+    ball.col = testcol;
+    env.setCell((int)ball.lin, (int)ball.col, 1);
+}
@@ -1,18 +1,24 @@
 #ifndef ROBOT_H
 #define ROBOT_H
 
+#include <cstdint>
+
+#include "direction.h"
 #include "environment.h"
+#include "gp_random.hpp"
+
+struct ball_data;
 
 class Robot {
 private:
     double lin;
     double col;
-    int dir;
+    int dir; // Heading in degrees, index into DIRECTIONS
     Environment& env;
 
 public:
     Robot(Environment& environment);
-    void initialize();
+    void initialize(gp::Rng& rng);
     void walkFront();
     void walkBack();
     void turnLeft();
@@ -22,6 +28,11 @@ public:
     bool canSeeBall(double ballLin, double ballCol) const;
     bool canSeeAndReachBall(double ballLin, double ballCol, double angle) const;
     
+    // Motion rules on plain state, shared with the batched simulator
+    static void tryStep(Environment& env, double& lin, double& col, const StepVector& step);
+    static int alignedHeading(const Environment& env, double lin, double col, int dir, double ballLin, double ballCol);
+    static bool seesBall(const Environment& env, double lin, double col, int dir, double ballLin, double ballCol);
+
     // Getters
     double getLine() const { return lin; }
     double getColumn() const { return col; }
@@ -31,4 +42,13 @@ public:
     friend void moveball(struct ball_data* ball, const Robot& robot);
 };
 
+// Reset env and place robot and ball for one run of a scenario. Positions
+// depend only on (scenarioSeed, runIndex). Returns the initial robot-ball
+// distance.
+double placeRun(Environment& env, Robot& robot, ball_data& ball, std::uint64_t scenarioSeed, int runIndex);
+
+// Push the ball two cells along heading after a hit, bouncing back off
+// walls and obstacles
+void kickBall(Environment& env, ball_data& ball, int heading);
+
 #endif // ROBOT_H
\ No newline at end of file
@@ -0,0 +1,679 @@
+#ifndef ROBOT_BATCH_HPP
+#define ROBOT_BATCH_HPP
+
+#include "robot_bytecode.hpp"
+#include "robot_commands.hpp"
+#include "robot.h"
+#include "environment.h"
+#include "constants.h"
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// AVX2 lane kernels, compiled with a target attribute and picked at run
+// time, so the binary still runs on CPUs without AVX2
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ROBOT_GP_BATCH_AVX2 1
+#define ROBOT_GP_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#else
+#define ROBOT_GP_BATCH_AVX2 0
+#endif
+
+namespace robot_gp {
+
+// Runs of one program simulated side by side
+inline constexpr int BATCH_LANES = 8;
+
+// Bit l set = lane l takes part
+using LaneMask = std::uint32_t;
+static_assert(BATCH_LANES <= 32);
+
+// True when the AVX2 lane kernels can run on this CPU
+inline bool batch_simd_supported() {
+#if ROBOT_GP_BATCH_AVX2
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+// Several runs (scenarios) of the same program, stored as structure of
+// arrays. Each lane owns an Environment and follows exactly the run a
+// Simulation would do for it: same start positions, same terminals in the
+// same order, same fitness. The machine of run_batch().
+//
+// With simd, which is off by default and needs a CPU with AVX2, moves,
+// turns, the wall test and the hit check run as AVX2 kernels over all
+// lanes, with masks for the lanes that take part; grid cells are gathered
+// from each lane's packed Environment. align() and the ball-visibility
+// test use polynomial atan2/sin/cos and redo per lane, with libm, every
+// lane too close to a threshold to trust (see UNSURE_MARGIN).
+class BatchSimulation {
+public:
+    BatchSimulation(int height, int width, bool simd = false)
+        : rows(height), cols(width), simd(simd && batch_simd_supported()) {
+        envs.reserve(BATCH_LANES);
+        robots.reserve(BATCH_LANES);
+        for (int l = 0; l < BATCH_LANES; ++l) {
+            envs.emplace_back(height, width);
+            envs.back().initialize();
+            robots.emplace_back(envs.back());
+            grids[l] = reinterpret_cast<std::uintptr_t>(envs.back().words());
+        }
+    }
+
+    [[nodiscard]] bool uses_simd() const { return simd; }
+
+    bool stop_on_repeat{true}; // Cycle detection as in Simulation::repeats()
+
+    // Robots are bound to their lane's Environment
+    BatchSimulation(const BatchSimulation&) = delete;
+    BatchSimulation& operator=(const BatchSimulation&) = delete;
+
+    // Place runs first_run .. first_run + count - 1 of a scenario in lanes
+    // 0 .. count - 1 and return their mask
+    LaneMask start(std::uint64_t scenario_seed, int first_run, int count) {
+        for (int l = 0; l < count; ++l) {
+            ball_data ball{};
+            initial_distance[l] = placeRun(envs[l], robots[l], ball, scenario_seed, first_run + l);
+            lin[l] = robots[l].getLine();
+            col[l] = robots[l].getColumn();
+            dir[l] = robots[l].getDirection();
+            ball_lin[l] = ball.lin;
+            ball_col[l] = ball.col;
+            ball_dir[l] = ball.dir;
+            hits[l] = 0;
+            unfit[l] = 0;
+            last_hit_step[l] = 0;
+            step[l] = 0;
+            checkpoint_period[l] = 0;
+        }
+        return count >= 32 ? ~LaneMask{0} : (LaneMask{1} << count) - 1;
+    }
+
+    // Terminals act on the lanes in mask, then run after_step on each of
+    // them. They return the lanes with budget left.
+    LaneMask walk_front(LaneMask mask, int budget) {
+#if ROBOT_GP_BATCH_AVX2
+        if (simd) {
+            walk_avx2(mask, false);
+            return after_step_avx2(mask, budget);
+        }
+#endif
+        return terminal(mask, budget, [&](int l) { Robot::tryStep(envs[l], lin[l], col[l], DIRECTIONS[dir[l]]); });
+    }
+
+    LaneMask walk_back(LaneMask mask, int budget) {
+#if ROBOT_GP_BATCH_AVX2
+        if (simd) {
+            walk_avx2(mask, true);
+            return after_step_avx2(mask, budget);
+        }
+#endif
+        return terminal(mask, budget, [&](int l) { Robot::tryStep(envs[l], lin[l], col[l], stepFor(dir[l] + 180)); });
+    }
+
+    LaneMask turn_left(LaneMask mask, int budget) {
+#if ROBOT_GP_BATCH_AVX2
+        if (simd) {
+            turn_avx2(mask, ANGLE);
+            return after_step_avx2(mask, budget);
+        }
+#endif
+        return terminal(mask, budget, [&](int l) { dir[l] = dir[l] + ANGLE >= 360 ? dir[l] + ANGLE - 360 : dir[l] + ANGLE; });
+    }
+
+    LaneMask turn_right(LaneMask mask, int budget) {
+#if ROBOT_GP_BATCH_AVX2
+        if (simd) {
+            turn_avx2(mask, -ANGLE);
+            return after_step_avx2(mask, budget);
+        }
+#endif
+        return terminal(mask, budget, [&](int l) { dir[l] = dir[l] - ANGLE < 0 ? dir[l] - ANGLE + 360 : dir[l] - ANGLE; });
+    }
+
+    LaneMask align(LaneMask mask, int budget) {
+        auto action = [&](int l) {
+            dir[l] = Robot::alignedHeading(envs[l], lin[l], col[l], dir[l], ball_lin[l], ball_col[l]);
+        };
+#if ROBOT_GP_BATCH_AVX2
+        if (simd) {
+            for_lanes(align_avx2(mask), action);
+            return after_step_avx2(mask, budget);
+        }
+#endif
+        return terminal(mask, budget, action);
+    }
+
+    // Lanes of mask whose condition holds
+    [[nodiscard]] LaneMask near_wall(LaneMask mask) const {
+#if ROBOT_GP_BATCH_AVX2
+        if (simd) return near_wall_avx2(mask);
+#endif
+        LaneMask taken = 0;
+        for_lanes(mask, [&](int l) {
+            if (!envs[l].isPathClear(lin[l], col[l], dir[l], 2)) taken |= LaneMask{1} << l;
+        });
+        return taken;
+    }
+
+    [[nodiscard]] LaneMask sees_ball(LaneMask mask) const {
+#if ROBOT_GP_BATCH_AVX2
+        if (simd) return sees_ball_avx2(mask);
+#endif
+        LaneMask taken = 0;
+        for_lanes(mask, [&](int l) {
+            if (Robot::seesBall(envs[l], lin[l], col[l], dir[l], ball_lin[l], ball_col[l])) taken |= LaneMask{1} << l;
+        });
+        return taken;
+    }
+
+    // Lanes of mask whose robot starts within hit distance of the ball
+    [[nodiscard]] LaneMask within_reach(LaneMask mask) const {
+        LaneMask reach = 0;
+        for_lanes(mask, [&](int l) {
+            if (initial_distance[l] <= HIT_DISTANCE) reach |= LaneMask{1} << l;
+        });
+        return reach;
+    }
+
+    // Simulation::repeats() for every lane of mask, at a restart of the
+    // program; returns the lanes whose run can stop
+    LaneMask repeats(LaneMask mask) {
+        LaneMask done = 0;
+        if (!stop_on_repeat) return done;
+        for_lanes(mask, [&](int l) {
+            if (checkpoint_period[l] > 0 && checkpoint_occupied[l] && checkpoint_hits[l] == hits[l] &&
+                checkpoint_lin[l] == lin[l] && checkpoint_col[l] == col[l] && checkpoint_dir[l] == dir[l]) {
+                done |= LaneMask{1} << l;
+                return;
+            }
+            if (checkpoint_period[l] == 0 || ++checkpoint_passes[l] == checkpoint_period[l]) {
+                checkpoint_period[l] = checkpoint_period[l] == 0 ? 1 : 2 * checkpoint_period[l];
+                checkpoint_passes[l] = 0;
+                checkpoint_occupied[l] = envs[l].getCell((int)lin[l], (int)col[l]) == 1;
+                checkpoint_lin[l] = lin[l];
+                checkpoint_col[l] = col[l];
+                checkpoint_dir[l] = dir[l];
+                checkpoint_hits[l] = hits[l];
+            }
+        });
+        return done;
+    }
+
+    [[nodiscard]] double fitness(int lane) const {
+        return 1500 * hits[lane] - unfit[lane];
+    }
+
+    // Terminals the lane has executed since start()
+    [[nodiscard]] int steps(int lane) const {
+        return step[lane];
+    }
+
+private:
+    int rows;
+    int cols;
+    bool simd;
+    std::vector<Environment> envs;
+    std::vector<Robot> robots; // Only used to place the start positions
+    alignas(32) std::array<std::uintptr_t, BATCH_LANES> grids; // envs[l].words()
+
+    alignas(64) std::array<double, BATCH_LANES> lin{};
+    alignas(64) std::array<double, BATCH_LANES> col{};
+    alignas(64) std::array<double, BATCH_LANES> ball_lin{};
+    alignas(64) std::array<double, BATCH_LANES> ball_col{};
+    alignas(64) std::array<double, BATCH_LANES> initial_distance{};
+    alignas(32) std::array<int, BATCH_LANES> dir{};
+    alignas(32) std::array<int, BATCH_LANES> ball_dir{};
+    alignas(32) std::array<int, BATCH_LANES> hits{};
+    alignas(32) std::array<int, BATCH_LANES> unfit{};
+    alignas(32) std::array<int, BATCH_LANES> last_hit_step{};
+    alignas(32) std::array<int, BATCH_LANES> step{}; // Terminals executed so far
+
+    // Cycle-detection checkpoints; period 0 = none taken yet
+    std::array<double, BATCH_LANES> checkpoint_lin{};
+    std::array<double, BATCH_LANES> checkpoint_col{};
+    std::array<int, BATCH_LANES> checkpoint_dir{};
+    std::array<int, BATCH_LANES> checkpoint_hits{};
+    std::array<int, BATCH_LANES> checkpoint_passes{};
+    std::array<int, BATCH_LANES> checkpoint_period{};
+    std::array<bool, BATCH_LANES> checkpoint_occupied{};
+
+    // Hit check and ball physics after a terminal, as Simulation::after_step
+    // with the lane's own step number. Clears the lane from mask once its
+    // budget is used up.
+    void after_step(int l, int budget, LaneMask& mask) {
+        const double dlin = ball_lin[l] - lin[l];
+        const double dcol = ball_col[l] - col[l];
+        if (dlin * dlin + dcol * dcol <= HIT_DISTANCE * HIT_DISTANCE) {
+            score_hit(l);
+        }
+        if (++step[l] == budget) mask &= ~(LaneMask{1} << l);
+    }
+
+    void score_hit(int l) {
+        hits[l]++;
+        unfit[l] += (step[l] - last_hit_step[l]) / initial_distance[l];
+        last_hit_step[l] = step[l];
+
+        ball_data ball{ball_dir[l], ball_lin[l], ball_col[l]};
+        kickBall(envs[l], ball, dir[l]);
+        ball_dir[l] = ball.dir;
+        ball_lin[l] = ball.lin;
+        ball_col[l] = ball.col;
+    }
+
+    template<typename F>
+    LaneMask terminal(LaneMask mask, int budget, F&& action) {
+        LaneMask running = mask;
+        for_lanes(mask, [&](int l) {
+            action(l);
+            after_step(l, budget, running);
+        });
+        return running;
+    }
+
+    template<typename F>
+    static void for_lanes(LaneMask mask, F&& f) {
+        for (; mask; mask &= mask - 1) {
+            f(std::countr_zero(mask));
+        }
+    }
+
+#if ROBOT_GP_BATCH_AVX2
+    static_assert(BATCH_LANES == 8, "AVX2 kernels handle 8 lanes: one vector of ints, two of doubles");
+    static_assert(sizeof(StepVector) == 2 * sizeof(double));
+
+    // Lanes of mask as 32-bit elements, all ones where set
+    ROBOT_GP_TARGET_AVX2 static __m256i lanes32(LaneMask mask) {
+        const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)mask), bits), bits);
+    }
+
+    // Lanes 4*half .. 4*half+3 of mask as 64-bit elements
+    ROBOT_GP_TARGET_AVX2 static __m256i lanes64(LaneMask mask, int half) {
+        const __m256i bits = _mm256_setr_epi64x(1, 2, 4, 8);
+        return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(mask >> (4 * half)), bits), bits);
+    }
+
+    // Headings of lanes 4*half .. 4*half+3
+    ROBOT_GP_TARGET_AVX2 static __m128i half_of(__m256i v, int half) {
+        return half ? _mm256_extracti128_si256(v, 1) : _mm256_castsi256_si128(v);
+    }
+
+    // Step vectors for four headings
+    ROBOT_GP_TARGET_AVX2 static void steps4(__m128i heading, __m256d& dlin, __m256d& dcol) {
+        const __m128i index = _mm_slli_epi32(heading, 1);
+        const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        dlin = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), &DIRECTIONS[0].dlin, index, all, 8);
+        dcol = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), &DIRECTIONS[0].dcol, index, all, 8);
+    }
+
+    // Grid cells (lin, col) of lanes 4*half .. 4*half+3 from each lane's
+    // own Environment. Lanes outside valid are not read and give 0.
+    ROBOT_GP_TARGET_AVX2 __m256i cells4(int half, __m128i lin4, __m128i col4, __m256i valid) const {
+        const __m256i cell = _mm256_cvtepi32_epi64(_mm_add_epi32(_mm_mullo_epi32(lin4, _mm_set1_epi32(cols)), col4));
+        const __m256i base = _mm256_load_si256(reinterpret_cast<const __m256i*>(&grids[4 * half]));
+        const __m256i address = _mm256_add_epi64(base, _mm256_slli_epi64(_mm256_srli_epi64(cell, 5), 3));
+        const __m256i words = _mm256_mask_i64gather_epi64(_mm256_setzero_si256(), nullptr, address, valid, 1);
+        const __m256i shift = _mm256_slli_epi64(_mm256_and_si256(cell, _mm256_set1_epi64x(31)), 1);
+        return _mm256_and_si256(_mm256_srlv_epi64(words, shift), _mm256_set1_epi64x(3));
+    }
+
+    // Robot::tryStep on every lane of mask: the target cells are tested in
+    // vector form, the grid writes of the lanes that move are per lane
+    ROBOT_GP_TARGET_AVX2 void walk_avx2(LaneMask mask, bool back) {
+        alignas(32) double next_lin[BATCH_LANES];
+        alignas(32) double next_col[BATCH_LANES];
+        __m256i heading = _mm256_load_si256(reinterpret_cast<const __m256i*>(dir.data()));
+        if (back) {
+            const __m256i turned = _mm256_add_epi32(heading, _mm256_set1_epi32(180));
+            const __m256i wrap = _mm256_cmpgt_epi32(turned, _mm256_set1_epi32(359));
+            heading = _mm256_sub_epi32(turned, _mm256_and_si256(wrap, _mm256_set1_epi32(360)));
+        }
+
+        LaneMask open = 0;
+        for (int half = 0; half < 2; ++half) {
+            __m256d dlin, dcol;
+            steps4(half_of(heading, half), dlin, dcol);
+            const __m256d test_lin = _mm256_add_pd(_mm256_load_pd(&lin[4 * half]), dlin);
+            const __m256d test_col = _mm256_add_pd(_mm256_load_pd(&col[4 * half]), dcol);
+            _mm256_store_pd(&next_lin[4 * half], test_lin);
+            _mm256_store_pd(&next_col[4 * half], test_col);
+
+            // getCell(): cells off the grid read as -1, i.e. blocked
+            const __m128i l4 = _mm256_cvttpd_epi32(test_lin);
+            const __m128i c4 = _mm256_cvttpd_epi32(test_col);
+            const __m128i inside = _mm_and_si128(
+                _mm_and_si128(_mm_cmpgt_epi32(l4, _mm_set1_epi32(-1)), _mm_cmplt_epi32(l4, _mm_set1_epi32(rows))),
+                _mm_and_si128(_mm_cmpgt_epi32(c4, _mm_set1_epi32(-1)), _mm_cmplt_epi32(c4, _mm_set1_epi32(cols))));
+            const __m256i valid = _mm256_and_si256(_mm256_cvtepi32_epi64(inside), lanes64(mask, half));
+            const __m256i empty = _mm256_and_si256(valid, _mm256_cmpeq_epi64(cells4(half, l4, c4, valid), _mm256_setzero_si256()));
+            open |= (LaneMask)_mm256_movemask_pd(_mm256_castsi256_pd(empty)) << (4 * half);
+        }
+
+        for_lanes(open, [&](int l) {
+            envs[l].setCell((int)lin[l], (int)col[l], 0);
+            lin[l] = next_lin[l];
+            col[l] = next_col[l];
+            envs[l].setCell((int)lin[l], (int)col[l], 1);
+        });
+    }
+
+    // turnLeft/turnRight on every lane of mask
+    ROBOT_GP_TARGET_AVX2 void turn_avx2(LaneMask mask, int delta) {
+        const __m256i current = _mm256_load_si256(reinterpret_cast<const __m256i*>(dir.data()));
+        __m256i turned = _mm256_add_epi32(current, _mm256_set1_epi32(delta));
+        turned = _mm256_add_epi32(turned, _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), turned), _mm256_set1_epi32(360)));
+        turned = _mm256_sub_epi32(turned, _mm256_and_si256(_mm256_cmpgt_epi32(turned, _mm256_set1_epi32(359)), _mm256_set1_epi32(360)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dir.data()), _mm256_blendv_epi8(current, turned, lanes32(mask)));
+    }
+
+    // Robot::isNearWall on every lane of mask: the cell two steps ahead
+    ROBOT_GP_TARGET_AVX2 LaneMask near_wall_avx2(LaneMask mask) const {
+        const __m256i heading = _mm256_load_si256(reinterpret_cast<const __m256i*>(dir.data()));
+        LaneMask clear = 0;
+        for (int half = 0; half < 2; ++half) {
+            __m256d dlin, dcol;
+            steps4(half_of(heading, half), dlin, dcol);
+            const __m256d two = _mm256_set1_pd(2.0);
+            const __m256d test_lin = _mm256_add_pd(_mm256_load_pd(&lin[4 * half]), _mm256_mul_pd(two, dlin));
+            const __m256d test_col = _mm256_add_pd(_mm256_load_pd(&col[4 * half]), _mm256_mul_pd(two, dcol));
+
+            // Environment::isPathClear: the border ring counts as blocked
+            const __m256d inside = _mm256_and_pd(
+                _mm256_and_pd(_mm256_cmp_pd(test_lin, _mm256_set1_pd(1), _CMP_GE_OQ),
+                              _mm256_cmp_pd(test_lin, _mm256_set1_pd(rows - 2), _CMP_LE_OQ)),
+                _mm256_and_pd(_mm256_cmp_pd(test_col, _mm256_set1_pd(1), _CMP_GE_OQ),
+                              _mm256_cmp_pd(test_col, _mm256_set1_pd(cols - 2), _CMP_LE_OQ)));
+            const __m256i valid = _mm256_and_si256(_mm256_castpd_si256(inside), lanes64(mask, half));
+            const __m256i cells = cells4(half, _mm256_cvttpd_epi32(test_lin), _mm256_cvttpd_epi32(test_col), valid);
+            const __m256i empty = _mm256_and_si256(valid, _mm256_cmpeq_epi64(cells, _mm256_setzero_si256()));
+            clear |= (LaneMask)_mm256_movemask_pd(_mm256_castsi256_pd(empty)) << (4 * half);
+        }
+        return mask & ~clear;
+    }
+
+    // The ball tests go through calculateAngleBetweenPoints (atan2) and
+    // isPathClear with a real angle (sin, cos). The kernels below compute
+    // them with polynomials accurate to ~1e-15 and only trust a lane when
+    // every value that gets truncated or compared lies more than
+    // UNSURE_MARGIN from the threshold; libm's results, within an ulp of
+    // the same functions, then lead to the same decisions. The other
+    // lanes, e.g. exact 0/45/90 degree angles from integer positions, are
+    // redone per lane with libm.
+    static constexpr double UNSURE_MARGIN = 1e-9;
+
+    ROBOT_GP_TARGET_AVX2 static __m256d near(__m256d value, double threshold) {
+        const __m256d distance = _mm256_sub_pd(value, _mm256_set1_pd(threshold));
+        return _mm256_cmp_pd(_mm256_andnot_pd(_mm256_set1_pd(-0.0), distance), _mm256_set1_pd(UNSURE_MARGIN), _CMP_LT_OQ);
+    }
+
+    ROBOT_GP_TARGET_AVX2 static __m256d near_integer(__m256d value) {
+        const __m256d distance = _mm256_sub_pd(value, _mm256_round_pd(value, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+        return _mm256_cmp_pd(_mm256_andnot_pd(_mm256_set1_pd(-0.0), distance), _mm256_set1_pd(UNSURE_MARGIN), _CMP_LT_OQ);
+    }
+
+    // atan(t) for t >= 0 (Cephes atan: three ranges, rational approximation)
+    ROBOT_GP_TARGET_AVX2 static __m256d atan4(__m256d t) {
+        const double MOREBITS = 6.123233995736765886130e-17;
+        const __m256d big = _mm256_cmp_pd(t, _mm256_set1_pd(2.41421356237309504880), _CMP_GT_OQ);
+        const __m256d mid = _mm256_andnot_pd(big, _mm256_cmp_pd(t, _mm256_set1_pd(0.66), _CMP_GT_OQ));
+        const __m256d one = _mm256_set1_pd(1.0);
+
+        __m256d x = _mm256_blendv_pd(t, _mm256_div_pd(_mm256_sub_pd(t, one), _mm256_add_pd(t, one)), mid);
+        x = _mm256_blendv_pd(x, _mm256_div_pd(_mm256_set1_pd(-1.0), t), big);
+        const __m256d base = _mm256_or_pd(_mm256_and_pd(mid, _mm256_set1_pd(M_PI_4)),
+                                          _mm256_and_pd(big, _mm256_set1_pd(M_PI_2)));
+        const __m256d extra = _mm256_or_pd(_mm256_and_pd(mid, _mm256_set1_pd(0.5 * MOREBITS)),
+                                           _mm256_and_pd(big, _mm256_set1_pd(MOREBITS)));
+
+        const __m256d z = _mm256_mul_pd(x, x);
+        __m256d p = _mm256_set1_pd(-8.750608600031904122785e-1);
+        p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(-1.615753718733365076637e1));
+        p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(-7.500855792314704667340e1));
+        p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(-1.228866684490136173410e2));
+        p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(-6.485021904942025371773e1));
+        __m256d q = _mm256_add_pd(z, _mm256_set1_pd(2.485846490142306297962e1));
+        q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(1.650270098316988542046e2));
+        q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(4.328810604912902668951e2));
+        q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(4.853903996359136964868e2));
+        q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(1.945506571482613964425e2));
+        const __m256d r = _mm256_add_pd(_mm256_mul_pd(x, _mm256_div_pd(_mm256_mul_pd(z, p), q)), x);
+        return _mm256_add_pd(base, _mm256_add_pd(r, extra));
+    }
+
+    // sin and cos of x in [0, 2*pi] (quadrant reduction, Cephes polynomials on [-pi/4, pi/4])
+    ROBOT_GP_TARGET_AVX2 static void sincos4(__m256d x, __m256d& sine, __m256d& cosine) {
+        const __m256d q = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(M_2_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        const __m256d r = _mm256_sub_pd(_mm256_sub_pd(x, _mm256_mul_pd(q, _mm256_set1_pd(1.57079632673412561417e+00))),
+                                        _mm256_mul_pd(q, _mm256_set1_pd(6.07710050650619224932e-11)));
+        const __m256d z = _mm256_mul_pd(r, r);
+
+        __m256d ps = _mm256_set1_pd(1.58962301576546568060e-10);
+        ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(-2.50507477628578072866e-8));
+        ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(2.75573136213857245213e-6));
+        ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(-1.98412698295895385996e-4));
+        ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(8.33333333332211858878e-3));
+        ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(-1.66666666666666307295e-1));
+        const __m256d s = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(r, z), ps));
+
+        __m256d pc = _mm256_set1_pd(-1.13585365213876817300e-11);
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(2.08757008419747316778e-9));
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(-2.75573141792967388112e-7));
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(2.48015872888517045348e-5));
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(-1.38888888888730564116e-3));
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(4.16666666666665929218e-2));
+        const __m256d c = _mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), _mm256_mul_pd(_mm256_set1_pd(0.5), z)),
+                                        _mm256_mul_pd(_mm256_mul_pd(z, z), pc));
+
+        // Quadrant k: sin = s, c, -s, -c and cos = c, -s, -c, s
+        const __m256i k = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(q));
+        const __m256d odd = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(k, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(1)));
+        const __m256i sin_sign = _mm256_slli_epi64(_mm256_and_si256(k, _mm256_set1_epi64x(2)), 62);
+        const __m256i cos_sign = _mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(k, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(2)), 62);
+        sine = _mm256_xor_pd(_mm256_blendv_pd(s, c, odd), _mm256_castsi256_pd(sin_sign));
+        cosine = _mm256_xor_pd(_mm256_blendv_pd(c, s, odd), _mm256_castsi256_pd(cos_sign));
+    }
+
+    // calculateAngleBetweenPoints from lanes 4*half .. 4*half+3 to their
+    // ball; unsure gets the lanes whose angle may differ from libm's
+    // around 0/360
+    ROBOT_GP_TARGET_AVX2 __m256d ball_angle4(int half, __m256d& unsure) const {
+        const __m256d dy = _mm256_sub_pd(_mm256_load_pd(&ball_lin[4 * half]), _mm256_load_pd(&lin[4 * half]));
+        const __m256d dx = _mm256_sub_pd(_mm256_load_pd(&ball_col[4 * half]), _mm256_load_pd(&col[4 * half]));
+        const __m256d sign = _mm256_set1_pd(-0.0);
+        const __m256d zero = _mm256_setzero_pd();
+
+        // atan2(dy, dx) from atan(|dy| / |dx|); a zero side goes to libm
+        __m256d a = atan4(_mm256_div_pd(_mm256_andnot_pd(sign, dy), _mm256_andnot_pd(sign, dx)));
+        const __m256d west = _mm256_cmp_pd(dx, zero, _CMP_LT_OQ);
+        a = _mm256_blendv_pd(a, _mm256_sub_pd(_mm256_set1_pd(M_PI), a), west);
+        a = _mm256_xor_pd(a, _mm256_and_pd(dy, sign));
+        unsure = _mm256_or_pd(_mm256_cmp_pd(dx, zero, _CMP_EQ_OQ), _mm256_cmp_pd(dy, zero, _CMP_EQ_OQ));
+
+        const __m256d degrees = _mm256_mul_pd(_mm256_set1_pd(180 / M_PI), a);
+        __m256d angle = _mm256_blendv_pd(_mm256_sub_pd(_mm256_set1_pd(360), degrees),
+                                         _mm256_sub_pd(_mm256_set1_pd(180), degrees), west);
+        unsure = _mm256_or_pd(unsure, _mm256_or_pd(near(angle, 360), near(angle, 0)));
+
+        // normalizeAngle
+        angle = _mm256_sub_pd(angle, _mm256_and_pd(_mm256_cmp_pd(angle, _mm256_set1_pd(360), _CMP_GE_OQ), _mm256_set1_pd(360)));
+        angle = _mm256_add_pd(angle, _mm256_and_pd(_mm256_cmp_pd(angle, zero, _CMP_LT_OQ), _mm256_set1_pd(360)));
+        return angle;
+    }
+
+    // Environment::isPathClear(lin, col, angle, 1) for lanes 4*half ..
+    // 4*half+3 of valid; unsure gets the lanes whose target may fall in
+    // another cell with libm's sin/cos
+    ROBOT_GP_TARGET_AVX2 __m256d path_clear4(int half, __m256d angle, __m256d valid, __m256d& unsure) const {
+        __m256d sine, cosine;
+        sincos4(_mm256_div_pd(_mm256_mul_pd(_mm256_set1_pd(M_PI), angle), _mm256_set1_pd(180)), sine, cosine);
+        const __m256d test_lin = _mm256_sub_pd(_mm256_load_pd(&lin[4 * half]), sine);
+        const __m256d test_col = _mm256_add_pd(_mm256_load_pd(&col[4 * half]), cosine);
+        unsure = _mm256_or_pd(near_integer(test_lin), near_integer(test_col));
+
+        const __m256d inside = _mm256_and_pd(
+            _mm256_and_pd(_mm256_cmp_pd(test_lin, _mm256_set1_pd(1), _CMP_GE_OQ),
+                          _mm256_cmp_pd(test_lin, _mm256_set1_pd(rows - 2), _CMP_LE_OQ)),
+            _mm256_and_pd(_mm256_cmp_pd(test_col, _mm256_set1_pd(1), _CMP_GE_OQ),
+                          _mm256_cmp_pd(test_col, _mm256_set1_pd(cols - 2), _CMP_LE_OQ)));
+        const __m256i read = _mm256_castpd_si256(_mm256_and_pd(inside, valid));
+        const __m256i cells = cells4(half, _mm256_cvttpd_epi32(test_lin), _mm256_cvttpd_epi32(test_col), read);
+        return _mm256_castsi256_pd(_mm256_and_si256(read, _mm256_cmpeq_epi64(cells, _mm256_setzero_si256())));
+    }
+
+    // Robot::seesBall on every lane of mask; unsure lanes per lane
+    ROBOT_GP_TARGET_AVX2 LaneMask sees_ball_avx2(LaneMask mask) const {
+        const __m256i heading = _mm256_load_si256(reinterpret_cast<const __m256i*>(dir.data()));
+        LaneMask taken = 0;
+        LaneMask unsure = 0;
+        for (int half = 0; half < 2; ++half) {
+            const __m256d valid = _mm256_castsi256_pd(lanes64(mask, half));
+            __m256d unsure_angle, unsure_path;
+            const __m256d angle = ball_angle4(half, unsure_angle);
+            const __m256d offset = _mm256_sub_pd(angle, _mm256_cvtepi32_pd(half_of(heading, half)));
+            const __m256d outside = _mm256_or_pd(_mm256_cmp_pd(offset, _mm256_set1_pd(VIEW_ANGLE + 1), _CMP_GE_OQ),
+                                                 _mm256_cmp_pd(offset, _mm256_set1_pd(-VIEW_ANGLE - 1), _CMP_LE_OQ));
+            unsure_angle = _mm256_or_pd(unsure_angle, _mm256_or_pd(near(offset, VIEW_ANGLE + 1), near(offset, -VIEW_ANGLE - 1)));
+            const __m256d clear = path_clear4(half, angle, _mm256_and_pd(valid, outside), unsure_path);
+
+            // In view, or out of view with the way blocked
+            const __m256d sees = _mm256_andnot_pd(_mm256_and_pd(outside, clear), valid);
+            const __m256d doubt = _mm256_and_pd(valid, _mm256_or_pd(unsure_angle, _mm256_and_pd(outside, unsure_path)));
+            taken |= (LaneMask)_mm256_movemask_pd(sees) << (4 * half);
+            unsure |= (LaneMask)_mm256_movemask_pd(doubt) << (4 * half);
+        }
+
+        taken &= ~unsure;
+        for_lanes(unsure, [&](int l) {
+            if (Robot::seesBall(envs[l], lin[l], col[l], dir[l], ball_lin[l], ball_col[l])) taken |= LaneMask{1} << l;
+        });
+        return taken;
+    }
+
+    // Robot::alignedHeading on every lane of mask. Returns the lanes left
+    // for the per-lane code.
+    ROBOT_GP_TARGET_AVX2 LaneMask align_avx2(LaneMask mask) {
+        const __m256i heading = _mm256_load_si256(reinterpret_cast<const __m256i*>(dir.data()));
+        __m128i aligned[2];
+        LaneMask turn = 0;
+        LaneMask unsure = 0;
+        for (int half = 0; half < 2; ++half) {
+            const __m256d valid = _mm256_castsi256_pd(lanes64(mask, half));
+            __m256d unsure_angle, unsure_path;
+            const __m256d angle = ball_angle4(half, unsure_angle);
+            const __m256d offset = _mm256_sub_pd(angle, _mm256_cvtepi32_pd(half_of(heading, half)));
+            const __m256d in_range = _mm256_and_pd(_mm256_cmp_pd(offset, _mm256_set1_pd(VIEW_ANGLE + 1), _CMP_LT_OQ),
+                                                   _mm256_cmp_pd(offset, _mm256_set1_pd(-VIEW_ANGLE - 1), _CMP_GT_OQ));
+            unsure_angle = _mm256_or_pd(unsure_angle, _mm256_or_pd(near(offset, VIEW_ANGLE + 1), near(offset, -VIEW_ANGLE - 1)));
+            const __m256d clear = path_clear4(half, angle, _mm256_and_pd(valid, in_range), unsure_path);
+
+            // Turns to the truncated angle when it is in range and the way is clear
+            const __m256d turns = _mm256_and_pd(valid, _mm256_and_pd(in_range, clear));
+            const __m256d doubt = _mm256_and_pd(valid, _mm256_or_pd(unsure_angle, _mm256_and_pd(in_range,
+                _mm256_or_pd(unsure_path, _mm256_and_pd(clear, near_integer(angle))))));
+            aligned[half] = _mm256_cvttpd_epi32(angle);
+            turn |= (LaneMask)_mm256_movemask_pd(turns) << (4 * half);
+            unsure |= (LaneMask)_mm256_movemask_pd(doubt) << (4 * half);
+        }
+
+        const __m256i turned = _mm256_set_m128i(aligned[1], aligned[0]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dir.data()), _mm256_blendv_epi8(heading, turned, lanes32(turn & ~unsure)));
+        return unsure;
+    }
+
+    // after_step on every lane of mask: distances and step counters in
+    // vector form, hits (rare) handled per lane
+    ROBOT_GP_TARGET_AVX2 LaneMask after_step_avx2(LaneMask mask, int budget) {
+        LaneMask hit = 0;
+        for (int half = 0; half < 2; ++half) {
+            const __m256d dlin = _mm256_sub_pd(_mm256_load_pd(&ball_lin[4 * half]), _mm256_load_pd(&lin[4 * half]));
+            const __m256d dcol = _mm256_sub_pd(_mm256_load_pd(&ball_col[4 * half]), _mm256_load_pd(&col[4 * half]));
+            const __m256d squared = _mm256_add_pd(_mm256_mul_pd(dlin, dlin), _mm256_mul_pd(dcol, dcol));
+            hit |= (LaneMask)_mm256_movemask_pd(_mm256_cmp_pd(squared, _mm256_set1_pd(HIT_DISTANCE * HIT_DISTANCE), _CMP_LE_OQ)) << (4 * half);
+        }
+        for_lanes(hit & mask, [&](int l) { score_hit(l); });
+
+        const __m256i active = lanes32(mask);
+        const __m256i steps = _mm256_sub_epi32(_mm256_load_si256(reinterpret_cast<const __m256i*>(step.data())), active);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(step.data()), steps);
+        const __m256i done = _mm256_and_si256(active, _mm256_cmpeq_epi32(steps, _mm256_set1_epi32(budget)));
+        return mask & ~(LaneMask)_mm256_movemask_ps(_mm256_castsi256_ps(done));
+    }
+#endif
+};
+
+namespace detail {
+
+// Run the structured range code[begin, end) for the lanes in mask. Both
+// sides of a conditional run in turn, each with the lanes that take it,
+// so lanes stay on the same instruction outside conditionals. Returns the
+// lanes that still have budget.
+template<typename Machine>
+LaneMask run_range(const Program& program, size_t begin, size_t end, Machine& machine, LaneMask mask, int budget) {
+    const Instruction* const code = program.code.data();
+    const size_t restart = program.code.size() - 1;
+    size_t pc = begin;
+
+    while (pc < end && mask) {
+        switch (static_cast<OpCode>(code[pc].op)) {
+            case OpCode::WALKFRONT: mask = machine.walk_front(mask, budget); break;
+            case OpCode::WALKBACK:  mask = machine.walk_back(mask, budget);  break;
+            case OpCode::LEFT:      mask = machine.turn_left(mask, budget);  break;
+            case OpCode::RIGHT:     mask = machine.turn_right(mask, budget); break;
+            case OpCode::ALIGN:     mask = machine.align(mask, budget);      break;
+            case OpCode::IFWALL:
+            case OpCode::IFBALL: {
+                const LaneMask taken = static_cast<OpCode>(code[pc].op) == OpCode::IFWALL
+                    ? machine.near_wall(mask) : machine.sees_ball(mask);
+                // The left branch ends with a JUMP past the right one, or with
+                // RESTART when the right branch runs to the end of the program
+                const size_t right = code[pc].target;
+                const Instruction close = code[right - 1];
+                const size_t after = static_cast<OpCode>(close.op) == OpCode::JUMP ? close.target : restart;
+                mask = run_range(program, pc + 1, right - 1, machine, taken, budget)
+                     | run_range(program, right, after, machine, mask & ~taken, budget);
+                pc = after;
+                continue;
+            }
+            case OpCode::JUMP:
+            case OpCode::RESTART:
+                // Only closes conditionals and the program; never inside a range
+                return mask;
+        }
+        ++pc;
+    }
+    return mask;
+}
+
+} // namespace detail
+
+// Run a compiled program on every lane in mask until each has executed
+// `budget` terminals. Per lane the result is the same as run() on its own.
+//
+// Machine provides the terminals walk_front, walk_back, turn_left,
+// turn_right and align, which take (lanes, budget), act and run the
+// after-step rules on those lanes and return the ones with budget left, and
+// near_wall and sees_ball, which return the lanes of their argument where
+// the condition holds, and repeats(lanes), asked at every restart, which
+// returns the lanes whose run can end early.
+template<typename Machine>
+void run_batch(const Program& program, Machine& machine, LaneMask mask, int budget) {
+    if (program.empty() || budget <= 0) return;
+    const size_t restart = program.code.size() - 1;
+    while (mask) {
+        mask = detail::run_range(program, 0, restart, machine, mask, budget);
+        mask &= ~machine.repeats(mask);
+    }
+}
+
+} // namespace robot_gp
+
+#endif // ROBOT_BATCH_HPP
@@ -0,0 +1,219 @@
+#ifndef ROBOT_BYTECODE_HPP
+#define ROBOT_BYTECODE_HPP
+
+#include "gp_engine.hpp"
+#include "gp_linear_tree.hpp"
+#include "robot_commands.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace robot_gp {
+
+// Compiled form of a robot program.
+//
+// PROGN2/PROGN3 disappear (their children are laid out in sequence),
+// IFWALL/IFBALL fall through into the left branch and jump to the right
+// branch when the condition is false, and the left branch ends with a
+// JUMP over the right one. RESTART closes the program: the tree is
+// executed from the root again until the step budget runs out.
+enum class OpCode : std::uint8_t {
+    WALKFRONT,
+    WALKBACK,
+    LEFT,
+    RIGHT,
+    ALIGN,
+    IFWALL,     // target = else branch
+    IFBALL,     // target = else branch
+    JUMP,       // target = next instruction to run
+    RESTART
+};
+
+struct Instruction {
+    std::uint32_t op : 8;
+    std::uint32_t target : 24;
+};
+static_assert(sizeof(Instruction) == 4);
+
+struct Program {
+    std::vector<Instruction> code;
+
+    [[nodiscard]] bool empty() const { return code.empty(); }
+};
+
+namespace detail {
+
+inline size_t emit(std::vector<Instruction>& code, std::span<const RobotNodeValue> prefix, size_t index) {
+    auto op = [](OpCode o, std::uint32_t target = 0) {
+        return Instruction{static_cast<std::uint32_t>(o), target};
+    };
+
+    switch (prefix[index].cmd) {
+        case RobotCommand::PROGN3:
+        case RobotCommand::PROGN2: {
+            size_t next = index + 1;
+            for (size_t c = 0; c < prefix[index].children_count(); ++c) {
+                next = emit(code, prefix, next);
+            }
+            return next;
+        }
+        case RobotCommand::IFWALL:
+        case RobotCommand::IFBALL: {
+            const size_t branch = code.size();
+            code.push_back(op(prefix[index].cmd == RobotCommand::IFWALL ? OpCode::IFWALL : OpCode::IFBALL));
+            size_t next = emit(code, prefix, index + 1);
+            const size_t skip = code.size();
+            code.push_back(op(OpCode::JUMP));
+            code[branch].target = static_cast<std::uint32_t>(code.size());
+            next = emit(code, prefix, next);
+            code[skip].target = static_cast<std::uint32_t>(code.size());
+            return next;
+        }
+        case RobotCommand::WALKFRONT: code.push_back(op(OpCode::WALKFRONT)); break;
+        case RobotCommand::WALKBACK:  code.push_back(op(OpCode::WALKBACK));  break;
+        case RobotCommand::LEFT:      code.push_back(op(OpCode::LEFT));      break;
+        case RobotCommand::RIGHT:     code.push_back(op(OpCode::RIGHT));     break;
+        case RobotCommand::ALIGN:     code.push_back(op(OpCode::ALIGN));     break;
+    }
+    return index + 1;
+}
+
+} // namespace detail
+
+// Compile a prefix-order program. The output buffer is reused across calls.
+inline void compile(std::span<const RobotNodeValue> prefix, Program& program) {
+    program.code.clear();
+    if (prefix.empty()) return;
+    detail::emit(program.code, prefix, 0);
+    program.code.push_back(Instruction{static_cast<std::uint32_t>(OpCode::RESTART), 0});
+
+    // A JUMP landing on RESTART can restart directly
+    for (auto& instr : program.code) {
+        if (instr.op == static_cast<std::uint32_t>(OpCode::JUMP) &&
+            program.code[instr.target].op == static_cast<std::uint32_t>(OpCode::RESTART)) {
+            instr.op = static_cast<std::uint32_t>(OpCode::RESTART);
+        }
+    }
+}
+
+// False when the program has no WALKFRONT/WALKBACK: its robot never
+// leaves the start cell, so a ball out of reach at the start stays there
+[[nodiscard]] inline bool can_move(const Program& program) {
+    for (const auto& instr : program.code) {
+        if (instr.op == static_cast<std::uint32_t>(OpCode::WALKFRONT) ||
+            instr.op == static_cast<std::uint32_t>(OpCode::WALKBACK)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void compile(const gp::LinearTree<RobotNodeValue>& tree, Program& program) {
+    compile(std::span<const RobotNodeValue>(tree.code), program);
+}
+
+inline void compile(const gp::Tree<RobotNodeValue>& tree, Program& program) {
+    const auto prefix = tree.prefix();
+    compile(std::span<const RobotNodeValue>(prefix), program);
+}
+
+// Run a compiled program until `budget` terminals have executed. Returns
+// the number of terminals executed, fewer when repeats() ended the run.
+//
+// Machine provides walk_front, walk_back, turn_left, turn_right, align,
+// near_wall, sees_ball, after_step(int step), which runs after every
+// terminal with its 0-based step number, and repeats(), asked at every
+// restart of the program: true ends the run early because the rest can
+// no longer change the result.
+template<typename Machine>
+int run(const Program& program, Machine& machine, int budget) {
+    if (program.empty() || budget <= 0) return 0;
+
+    const Instruction* const code = program.code.data();
+    const Instruction* pc = code;
+    int step = 0;
+
+#define ROBOT_GP_TERMINAL(action)                   \
+    machine.action();                               \
+    machine.after_step(step);                       \
+    if (++step == budget) return step;              \
+    ++pc;
+
+#if defined(__GNUC__)
+    // Threaded dispatch: one indirect jump per instruction
+    static const void* const labels[] = {
+        &&op_walkfront, &&op_walkback, &&op_left, &&op_right, &&op_align,
+        &&op_ifwall, &&op_ifball, &&op_jump, &&op_restart
+    };
+#define ROBOT_GP_DISPATCH() goto *labels[pc->op]
+
+    ROBOT_GP_DISPATCH();
+op_walkfront: ROBOT_GP_TERMINAL(walk_front) ROBOT_GP_DISPATCH();
+op_walkback:  ROBOT_GP_TERMINAL(walk_back)  ROBOT_GP_DISPATCH();
+op_left:      ROBOT_GP_TERMINAL(turn_left)  ROBOT_GP_DISPATCH();
+op_right:     ROBOT_GP_TERMINAL(turn_right) ROBOT_GP_DISPATCH();
+op_align:     ROBOT_GP_TERMINAL(align)      ROBOT_GP_DISPATCH();
+op_ifwall:    pc = machine.near_wall() ? pc + 1 : code + pc->target; ROBOT_GP_DISPATCH();
+op_ifball:    pc = machine.sees_ball() ? pc + 1 : code + pc->target; ROBOT_GP_DISPATCH();
+op_jump:      pc = code + pc->target; ROBOT_GP_DISPATCH();
+op_restart:   if (machine.repeats()) return step; pc = code; ROBOT_GP_DISPATCH();
+
+#undef ROBOT_GP_DISPATCH
+#else
+    for (;;) {
+        switch (static_cast<OpCode>(pc->op)) {
+            case OpCode::WALKFRONT: ROBOT_GP_TERMINAL(walk_front) break;
+            case OpCode::WALKBACK:  ROBOT_GP_TERMINAL(walk_back)  break;
+            case OpCode::LEFT:      ROBOT_GP_TERMINAL(turn_left)  break;
+            case OpCode::RIGHT:     ROBOT_GP_TERMINAL(turn_right) break;
+            case OpCode::ALIGN:     ROBOT_GP_TERMINAL(align)      break;
+            case OpCode::IFWALL:    pc = machine.near_wall() ? pc + 1 : code + pc->target; break;
+            case OpCode::IFBALL:    pc = machine.sees_ball() ? pc + 1 : code + pc->target; break;
+            case OpCode::JUMP:      pc = code + pc->target; break;
+            case OpCode::RESTART:
+                if (machine.repeats()) return step;
+                pc = code;
+                break;
+        }
+    }
+#endif
+#undef ROBOT_GP_TERMINAL
+}
+
+// Reference interpreter walking the pointer tree directly, with the same
+// semantics as run(). Kept to cross-check and benchmark the compiled path.
+template<typename Machine>
+void run_tree(const gp::Tree<RobotNodeValue>& tree, Machine& machine, int budget) {
+    if (!tree.root || budget <= 0) return;
+    int step = 0;
+
+    // Returns false once the budget is exhausted
+    auto walk = [&](auto& self, const gp::Node<RobotNodeValue>* node) -> bool {
+        switch (node->value.value.cmd) {
+            case RobotCommand::PROGN3:
+            case RobotCommand::PROGN2:
+                for (const auto& child : node->children) {
+                    if (!self(self, child.get())) return false;
+                }
+                return true;
+            case RobotCommand::IFWALL:
+                return self(self, node->children[machine.near_wall() ? 0 : 1].get());
+            case RobotCommand::IFBALL:
+                return self(self, node->children[machine.sees_ball() ? 0 : 1].get());
+            case RobotCommand::WALKFRONT: machine.walk_front(); break;
+            case RobotCommand::WALKBACK:  machine.walk_back();  break;
+            case RobotCommand::LEFT:      machine.turn_left();  break;
+            case RobotCommand::RIGHT:     machine.turn_right(); break;
+            case RobotCommand::ALIGN:     machine.align();      break;
+        }
+        machine.after_step(step);
+        return ++step < budget;
+    };
+
+    while (walk(walk, tree.root.get()) && !machine.repeats()) {}
+}
+
+} // namespace robot_gp
+
+#endif // ROBOT_BYTECODE_HPP
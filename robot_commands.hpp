@@ -0,0 +1,98 @@
+#ifndef ROBOT_COMMANDS_HPP
+#define ROBOT_COMMANDS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+
+struct ball_data {
+    int dir;       // Heading in degrees, index into DIRECTIONS
+    double lin;
+    double col;
+};
+
+namespace robot_gp {
+
+// Command types
+enum class RobotCommand : std::uint8_t {
+    // Function nodes
+    PROGN3,     // Execute 3 commands in sequence
+    PROGN2,     // Execute 2 commands in sequence
+    IFWALL,     // Execute left if near wall, right otherwise
+    IFBALL,     // Execute left if ball visible, right otherwise
+    
+    // Terminal nodes
+    WALKFRONT,  // Move forward
+    WALKBACK,   // Move backward
+    LEFT,       // Turn left
+    RIGHT,      // Turn right
+    ALIGN       // Orient towards ball
+};
+
+// Node value that holds a robot command
+struct RobotNodeValue {
+    RobotCommand cmd;
+    
+    // Get number of children required for this command
+    [[nodiscard]] size_t children_count() const {
+        switch (cmd) {
+            case RobotCommand::PROGN3:
+                return 3;
+            case RobotCommand::PROGN2:
+            case RobotCommand::IFWALL:
+            case RobotCommand::IFBALL:
+                return 2;
+            default:
+                return 0;
+        }
+    }
+    
+    // Check if this is a function node
+    [[nodiscard]] bool is_function() const {
+        return children_count() > 0;
+    }
+    
+    // Get character representation (for compatibility with existing code)
+    [[nodiscard]] char to_char() const {
+        switch (cmd) {
+            case RobotCommand::PROGN3: return '3';
+            case RobotCommand::PROGN2: return '2';
+            case RobotCommand::IFWALL: return 'I';
+            case RobotCommand::IFBALL: return 'C';
+            case RobotCommand::WALKFRONT: return 'F';
+            case RobotCommand::WALKBACK: return 'B';
+            case RobotCommand::LEFT: return 'L';
+            case RobotCommand::RIGHT: return 'R';
+            case RobotCommand::ALIGN: return 'A';
+        }
+        return '?';
+    }
+    
+    // Create from character (for compatibility with existing code)
+    static RobotNodeValue from_char(char c) {
+        switch (c) {
+            case '3': return {RobotCommand::PROGN3};
+            case '2': return {RobotCommand::PROGN2};
+            case 'I': return {RobotCommand::IFWALL};
+            case 'C': return {RobotCommand::IFBALL};
+            case 'F': return {RobotCommand::WALKFRONT};
+            case 'B': return {RobotCommand::WALKBACK};
+            case 'L': return {RobotCommand::LEFT};
+            case 'R': return {RobotCommand::RIGHT};
+            case 'A': return {RobotCommand::ALIGN};
+            default: throw std::invalid_argument("Invalid robot command character");
+        }
+    }
+};
+
+} // namespace robot_gp
+
+template<>
+struct std::hash<robot_gp::RobotNodeValue> {
+    size_t operator()(const robot_gp::RobotNodeValue& value) const noexcept {
+        return static_cast<size_t>(value.cmd);
+    }
+};
+
+#endif // ROBOT_COMMANDS_HPP
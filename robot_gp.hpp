@@ -2,91 +2,25 @@
 #define ROBOT_GP_HPP
 
 #include "gp_engine.hpp"
+#include "gp_linear_tree.hpp"
+#include "gp_profile.hpp"
+#include "gp_random.hpp"
+#include "gp_serialize.hpp"
+#include "robot_commands.hpp"
+#include "robot_bytecode.hpp"
+#include "robot_batch.hpp"
 #include "robot.h"
+#include "direction.h"
 #include "constants.h"
+#include <algorithm>
 #include <cmath>
-
-struct ball_data {
-    int dir;
-    double lin;
-    double col;
-};
+#include <cstdint>
+#include <memory>
 #include <variant>
+#include <vector>
 
 namespace robot_gp {
 
-// Command types
-enum class RobotCommand {
-    // Function nodes
-    PROGN3,     // Execute 3 commands in sequence
-    PROGN2,     // Execute 2 commands in sequence
-    IFWALL,     // Execute left if near wall, right otherwise
-    IFBALL,     // Execute left if ball visible, right otherwise
-    
-    // Terminal nodes
-    WALKFRONT,  // Move forward
-    WALKBACK,   // Move backward
-    LEFT,       // Turn left
-    RIGHT,      // Turn right
-    ALIGN       // Orient towards ball
-};
-
-// Node value that holds a robot command
-struct RobotNodeValue {
-    RobotCommand cmd;
-    
-    // Get number of children required for this command
-    [[nodiscard]] size_t children_count() const {
-        switch (cmd) {
-            case RobotCommand::PROGN3:
-                return 3;
-            case RobotCommand::PROGN2:
-            case RobotCommand::IFWALL:
-            case RobotCommand::IFBALL:
-                return 2;
-            default:
-                return 0;
-        }
-    }
-    
-    // Check if this is a function node
-    [[nodiscard]] bool is_function() const {
-        return children_count() > 0;
-    }
-    
-    // Get character representation (for compatibility with existing code)
-    [[nodiscard]] char to_char() const {
-        switch (cmd) {
-            case RobotCommand::PROGN3: return '3';
-            case RobotCommand::PROGN2: return '2';
-            case RobotCommand::IFWALL: return 'I';
-            case RobotCommand::IFBALL: return 'C';
-            case RobotCommand::WALKFRONT: return 'F';
-            case RobotCommand::WALKBACK: return 'B';
-            case RobotCommand::LEFT: return 'L';
-            case RobotCommand::RIGHT: return 'R';
-            case RobotCommand::ALIGN: return 'A';
-        }
-        return '?';
-    }
-    
-    // Create from character (for compatibility with existing code)
-    static RobotNodeValue from_char(char c) {
-        switch (c) {
-            case '3': return {RobotCommand::PROGN3};
-            case '2': return {RobotCommand::PROGN2};
-            case 'I': return {RobotCommand::IFWALL};
-            case 'C': return {RobotCommand::IFBALL};
-            case 'F': return {RobotCommand::WALKFRONT};
-            case 'B': return {RobotCommand::WALKBACK};
-            case 'L': return {RobotCommand::LEFT};
-            case 'R': return {RobotCommand::RIGHT};
-            case 'A': return {RobotCommand::ALIGN};
-            default: throw std::invalid_argument("Invalid robot command character");
-        }
-    }
-};
-
 // Evaluator class that executes robot commands
 class RobotEvaluator {
 private:
@@ -131,147 +65,277 @@ public:
     }
 };
 
-// Tree generator for robot programs
-// Fitness evaluator for robot programs
-class FitnessEvaluator {
-private:
+// Simulation state of one run; the machine driven by run()/run_tree().
+// after_step holds the hit check and ball physics applied after every
+// terminal.
+struct Simulation {
     Environment& env;
     Robot& robot;
     ball_data& ball;
-    RobotEvaluator evaluator;
-    
-    // Parameters (from original code)
-    // TODO: commenting for now, to uncomment once the old code is fully replaced
-    // static constexpr int RUNS = 1;          // Number of tests per individual
-    // static constexpr int EXECUTE = 2000;    // Number of tree executions per test
-    
-    // Evaluate a single run
-    double evaluate_run(const gp::Tree<RobotNodeValue>& tree) {
-        // Initialize environment and positions
-        env.initialize();
-        robot.initialize();
-        
-        // Reset tracking and hits
-        int hits = 0;
-        int unfit = 0;
-        double distance[2] = {0.0, 0.0};
-        int step = 0;
-        int last_hit_step = 0;
-        
-        // Initialize ball position
-        do {
-            ball.col = rand() % (WIDTH-2) + 1;
-            ball.lin = rand() % (HEIGHT-2) + 1;
-        } while (env.getCell(ball.lin, ball.col));
-        env.setCell(ball.lin, ball.col, 1);
-        
-        // Calculate initial distance
-        double initial_distance = std::sqrt(
-            std::pow(ball.lin - robot.getLine(), 2) +
-            std::pow(ball.col - robot.getColumn(), 2)
-        );
-        
-        // Execute program
-        for (; step < EXECUTE; ++step) {
-            // Execute one node of the program
-            auto* current = tree.root.get();
-            if (!current) break;
-            
-            switch (current->value.value.cmd) {
-                case RobotCommand::PROGN3:
-                    evaluator.execute_command(current->children[0]->value.value);
-                    evaluator.execute_command(current->children[1]->value.value);
-                    evaluator.execute_command(current->children[2]->value.value);
-                    break;
-                case RobotCommand::PROGN2:
-                    evaluator.execute_command(current->children[0]->value.value);
-                    evaluator.execute_command(current->children[1]->value.value);
-                    break;
-                case RobotCommand::IFWALL:
-                    evaluator.execute_command(
-                        current->children[evaluator.check_condition(current->value.value) ? 0 : 1]->value.value
-                    );
-                    break;
-                case RobotCommand::IFBALL:
-                    evaluator.execute_command(
-                        current->children[evaluator.check_condition(current->value.value) ? 0 : 1]->value.value
-                    );
-                    break;
-                default:
-                    evaluator.execute_command(current->value.value);
-            }
-            
-            // Check if robot hit ball
-            double hit_distance = std::sqrt(
-                std::pow(ball.lin - robot.getLine(), 2) +
-                std::pow(ball.col - robot.getColumn(), 2)
-            );
+    int hits{0};
+    int unfit{0};
+    int last_hit_step{0};
+    double initial_distance{0.0};
+    bool stop_on_repeat{true};
+
+    // Robot as of the last cycle-detection checkpoint
+    struct Checkpoint {
+        bool taken{false};
+        bool occupied{false}; // Robot's cell was set
+        double lin{0.0};
+        double col{0.0};
+        int dir{0};
+        int hits{0};
+        int passes{0};        // Restarts since the checkpoint
+        int period{1};        // Restarts until the next checkpoint (Brent)
+    } checkpoint{};
+
+    void walk_front() { robot.walkFront(); }
+    void walk_back() { robot.walkBack(); }
+    void turn_left() { robot.turnLeft(); }
+    void turn_right() { robot.turnRight(); }
+    void align() { robot.align(ball.lin, ball.col); }
+    [[nodiscard]] bool near_wall() const { return robot.isNearWall(); }
+    [[nodiscard]] bool sees_ball() const { return robot.canSeeBall(ball.lin, ball.col); }
+
+    void after_step(int step) {
+        // Check if robot hit ball; squared distances, no square root
+        const double dlin = ball.lin - robot.getLine();
+        const double dcol = ball.col - robot.getColumn();
+
+        if (dlin * dlin + dcol * dcol <= HIT_DISTANCE * HIT_DISTANCE) {
+            hits++;
+            unfit += (step - last_hit_step) / initial_distance;
+            last_hit_step = step;
             
-            if (hit_distance <= HIT_DISTANCE) {
-                hits++;
-                unfit += (step - last_hit_step) / initial_distance;
-                last_hit_step = step;
-                
-                // Move ball after hit
-                ball.dir = robot.getDirection();
-                int ball_movements = 40;  // Fixed number of movements after hit
-                
-                // Move ball
-                if (ball_movements > 0) {
-                    ball_movements--;
-                    
-                    // Calculate next position
-                    double testlin = ball.lin - (2 * std::sin((M_PI * ball.dir) / 180));
-                    double testcol = ball.col + (2 * std::cos((M_PI * ball.dir) / 180));
-                    
-                    // Check bounds and adjust position
-                    if (testlin < 0 || testlin > HEIGHT-1 || 
-                        testcol < 0 || testcol > WIDTH-1 ||
-                        env.getCell((int)testlin, (int)testcol)) {
-                        // If hitting wall or obstacle, bounce
-                        ball.dir = (ball.dir + 180) % 360;
-                        testlin = ball.lin - (2 * std::sin((M_PI * ball.dir) / 180));
-                        testcol = ball.col + (2 * std::cos((M_PI * ball.dir) / 180));
-                    }
-                    
-                    // Update ball position
-                    env.setCell((int)ball.lin, (int)ball.col, 0);
-                    ball.lin = testlin;
-                    ball.col = testcol;
-                    env.setCell((int)ball.lin, (int)ball.col, 1);
-                }
-            }
+            kickBall(env, ball, robot.getDirection());
         }
-        
-        // Calculate fitness
+    }
+
+    // Asked at every restart of the program. True once the robot is back
+    // at the checkpoint's position and heading with no hit since: the ball
+    // has not moved, and if the robot's cell was set at the checkpoint,
+    // every cell it entered since was empty then and is empty again, so the
+    // grid is unchanged too. From the same state at the same instruction
+    // the run repeats those hitless passes until the budget runs out, and
+    // the fitness is already final.
+    bool repeats() {
+        if (!stop_on_repeat) return false;
+        if (checkpoint.taken && checkpoint.occupied && checkpoint.hits == hits &&
+            checkpoint.lin == robot.getLine() && checkpoint.col == robot.getColumn() &&
+            checkpoint.dir == robot.getDirection()) {
+            return true;
+        }
+        if (!checkpoint.taken || ++checkpoint.passes == checkpoint.period) {
+            checkpoint = {true, env.getCell((int)robot.getLine(), (int)robot.getColumn()) == 1,
+                          robot.getLine(), robot.getColumn(), robot.getDirection(), hits,
+                          0, checkpoint.taken ? 2 * checkpoint.period : 1};
+        }
+        return false;
+    }
+
+    [[nodiscard]] double fitness() const {
         return 1500 * hits - unfit;
     }
+};
+
+// One traced step of a replayed run. Positions are stored as float (within
+// ~1e-5 of a cell on a 200-cell grid), enough for drawing and analysis, and
+// a sample takes 24 bytes.
+struct TrajectorySample {
+    std::int32_t step;   // Terminals executed so far; 0 is the start position
+    float lin;
+    float col;
+    float ball_lin;
+    float ball_col;
+    std::int16_t dir;    // Robot heading in degrees
+    std::int16_t hits;   // Ball hits so far
+};
+
+// Trace of one run of one program under a scenario seed
+struct Trajectory {
+    std::uint64_t scenario_seed{0};
+    int run_index{0};
+    double fitness{0.0}; // Fitness of this run alone
+    std::vector<TrajectorySample> samples;
+};
+
+// Simulation that also records a sample after every terminal. Only used
+// for replays; evaluation runs the plain Simulation.
+struct TracingSimulation : Simulation {
+    std::vector<TrajectorySample>& samples;
+
+    void record(int executed) {
+        samples.push_back({
+            executed,
+            (float)robot.getLine(), (float)robot.getColumn(),
+            (float)ball.lin, (float)ball.col,
+            (std::int16_t)robot.getDirection(), (std::int16_t)hits
+        });
+    }
+
+    void after_step(int step) {
+        Simulation::after_step(step);
+        record(step + 1);
+    }
+
+    // The trace covers every step, cycles included
+    bool repeats() { return false; }
+};
+
+// How the runs of one scenario are simulated. SEQUENTIAL runs them one
+// after another. LANES steps them in lockstep, BATCH_LANES at a time
+// (BatchSimulation); it gives the same fitness but measures slower on
+// waller_bench's fitness/runs8 cases, so it is not the default.
+enum class RunBatching { SEQUENTIAL, LANES };
+
+// Fitness evaluator for robot programs.
+// Each evaluator owns its Environment/Robot/ball sandbox, so copies can be
+// handed to separate worker threads. A fitness is the mean over `runs`
+// runs of the scenario, simulated as `batching` says; batched lanes use
+// the AVX2 kernels when simd is set and the CPU has them. Those kernels
+// measure no faster than the per-lane code, so they are off by default.
+class FitnessEvaluator {
+private:
+    Environment env;
+    Robot robot{env};
+    ball_data ball{};
+    Program program; // Compiled once per evaluation, buffer reused
+    int runs;        // Runs per scenario (RUNS by default)
+    bool moves{true};                  // can_move(program)
+    bool early_termination{true};
+    std::unique_ptr<BatchSimulation> batch; // Only with RunBatching::LANES and runs > 1
+
+    // Place robot and ball for one run of a scenario; positions depend
+    // only on (scenario_seed, run_index)
+    Simulation start_run(std::uint64_t scenario_seed, int run_index) {
+        Simulation sim{env, robot, ball};
+        sim.initial_distance = placeRun(env, robot, ball, scenario_seed, run_index);
+        sim.stop_on_repeat = early_termination;
+        return sim;
+    }
+
+    // Evaluate a single run: the whole program is executed repeatedly from
+    // the root until EXECUTE terminals have run
+    double evaluate_run(std::uint64_t scenario_seed, int run_index) {
+        Simulation sim = start_run(scenario_seed, run_index);
+        // A robot that cannot move, with the ball out of reach, never hits it
+        if (early_termination && !moves && sim.initial_distance > HIT_DISTANCE) {
+            return sim.fitness();
+        }
+        gp::profile::count(gp::profile::Counter::STEPS, run(program, sim, EXECUTE));
+        return sim.fitness();
+    }
 
 public:
-    FitnessEvaluator(Environment& environment, Robot& r, ball_data& b)
-        : env(environment)
-        , robot(r)
-        , ball(b)
-        , evaluator(r, b) {}
-    
-    double operator()(const gp::Tree<RobotNodeValue>& tree) {
+    explicit FitnessEvaluator(int height = HEIGHT, int width = WIDTH, int runs = RUNS,
+                              RunBatching batching = RunBatching::SEQUENTIAL,
+                              bool simd = false)
+        : env(height, width), runs(std::max(1, runs)) {
+        env.initialize(); // Built once; each run only resets the cells it touched
+        if (batching == RunBatching::LANES && this->runs > 1) {
+            batch = std::make_unique<BatchSimulation>(height, width, simd);
+        }
+    }
+
+    // Copies get a fresh sandbox of the same size; robot must bind to its own environment
+    FitnessEvaluator(const FitnessEvaluator& other)
+        : FitnessEvaluator(other.env.height(), other.env.width(), other.runs,
+                           other.batch ? RunBatching::LANES : RunBatching::SEQUENTIAL,
+                           other.batch && other.batch->uses_simd()) {}
+    FitnessEvaluator& operator=(const FitnessEvaluator&) { return *this; }
+
+    [[nodiscard]] int runs_per_scenario() const { return runs; }
+
+    // Skip runs whose result is already known: robots that cannot move
+    // and cannot reach the ball, and runs caught in a hitless cycle. On by
+    // default; fitness is the same either way.
+    void set_early_termination(bool enabled) {
+        early_termination = enabled;
+        if (batch) batch->stop_on_repeat = enabled;
+    }
+
+    // Scenario (robot and ball start positions) is fully determined by the seed.
+    // Accepts any genome with the prefix-indexed interface (Tree, LinearTree).
+    template<typename Genome>
+    double operator()(const Genome& tree, std::uint64_t scenario_seed) {
+        gp::profile::ScopedPhase phase(gp::profile::Phase::SIMULATION);
+        gp::profile::count(gp::profile::Counter::EVALUATIONS, 1);
+        if constexpr (gp::profile::ENABLED) {
+            gp::profile::count(gp::profile::Counter::NODES_EVALUATED, tree.size());
+        }
+
+        if (!batch) {
+            return evaluate_sequential(tree, scenario_seed);
+        }
+
+        // Same sum, in run order, as evaluate_sequential()
+        compile(tree, program);
+        moves = can_move(program);
         double total_fitness = 0.0;
-        
-        // Run multiple evaluations
-        for (int run = 0; run < RUNS; ++run) {
-            total_fitness += evaluate_run(tree);
+        for (int first = 0; first < runs; first += BATCH_LANES) {
+            const int count = std::min(BATCH_LANES, runs - first);
+            LaneMask lanes = batch->start(scenario_seed, first, count);
+            if (early_termination && !moves) {
+                lanes = batch->within_reach(lanes);
+            }
+            run_batch(program, *batch, lanes, EXECUTE);
+            for (int lane = 0; lane < count; ++lane) {
+                total_fitness += batch->fitness(lane);
+                gp::profile::count(gp::profile::Counter::STEPS, batch->steps(lane));
+            }
         }
-        
-        return total_fitness / RUNS;
+        return total_fitness / runs;
+    }
+
+    // The runs simulated one after another: the default path, and the
+    // reference for cross-checks and benchmarks of the batched lanes
+    template<typename Genome>
+    double evaluate_sequential(const Genome& tree, std::uint64_t scenario_seed) {
+        compile(tree, program);
+        moves = can_move(program);
+        double total_fitness = 0.0;
+        for (int run = 0; run < runs; ++run) {
+            total_fitness += evaluate_run(scenario_seed, run);
+        }
+        return total_fitness / runs;
+    }
+
+    // Re-simulate one run of an already evaluated program, recording every
+    // step. The scenario seed and run index fully determine the run, so the
+    // trace is exactly what evaluation saw.
+    template<typename Genome>
+    Trajectory replay(const Genome& tree, std::uint64_t scenario_seed, int run_index = 0) {
+        compile(tree, program);
+        Trajectory trajectory{scenario_seed, run_index, 0.0, {}};
+        trajectory.samples.reserve(EXECUTE + 1);
+
+        TracingSimulation sim{start_run(scenario_seed, run_index), trajectory.samples};
+        sim.record(0);
+        run(program, sim, EXECUTE);
+        trajectory.fitness = sim.fitness();
+        return trajectory;
+    }
+
+    // Same evaluation through the pointer-tree walk instead of the compiled
+    // program; reference for cross-checks and benchmarks
+    double evaluate_tree_walk(const gp::Tree<RobotNodeValue>& tree, std::uint64_t scenario_seed) {
+        double total_fitness = 0.0;
+        for (int run = 0; run < runs; ++run) {
+            Simulation sim = start_run(scenario_seed, run);
+            run_tree(tree, sim, EXECUTE);
+            total_fitness += sim.fitness();
+        }
+        return total_fitness / runs;
     }
 };
 
 class TreeGenerator {
 private:
-    std::mt19937& rng;
+    gp::Rng& rng;
 
 public:
-    explicit TreeGenerator(std::mt19937& random_engine) : rng(random_engine) {}
+    explicit TreeGenerator(gp::Rng& random_engine) : rng(random_engine) {}
 
     // Generate random terminal command
     RobotNodeValue generate_terminal() {
@@ -283,8 +347,7 @@ public:
             RobotCommand::ALIGN
         };
         
-        std::uniform_int_distribution<size_t> dist(0, std::size(terminals) - 1);
-        return RobotNodeValue{terminals[dist(rng)]};
+        return RobotNodeValue{terminals[rng.below(std::size(terminals))]};
     }
 
     // Generate random function command
@@ -296,8 +359,7 @@ public:
             RobotCommand::IFBALL
         };
         
-        std::uniform_int_distribution<size_t> dist(0, std::size(functions) - 1);
-        return RobotNodeValue{functions[dist(rng)]};
+        return RobotNodeValue{functions[rng.below(std::size(functions))]};
     }
 
     // Point mutation - changes command while preserving arity
@@ -334,8 +396,7 @@ public:
                 if (depth <= 1) {
                     child_value = generate_terminal();
                 } else {
-                    std::uniform_int_distribution<int> dist(0, 1);
-                    child_value = dist(rng) == 0 ? generate_terminal() : generate_function();
+                    child_value = rng.below(2) == 0 ? generate_terminal() : generate_function();
                 }
                 
                 auto child = std::make_unique<Node<RobotNodeValue>>(child_value);
@@ -349,8 +410,30 @@ public:
         build_tree(tree.root.get(), max_depth);
         return tree;
     }
+
+    // Same random tree, flattened to the linear genome
+    gp::LinearTree<RobotNodeValue> generate_linear_tree(size_t max_depth) {
+        return gp::LinearTree<RobotNodeValue>(generate_tree(max_depth));
+    }
 };
 
 } // namespace robot_gp
 
+// Nine commands fit in 4 bits, two nodes per byte
+template<>
+struct gp::value_codec<robot_gp::RobotNodeValue> {
+    static constexpr unsigned BITS = 4;
+
+    static std::uint8_t encode(const robot_gp::RobotNodeValue& value) {
+        return static_cast<std::uint8_t>(value.cmd);
+    }
+
+    static robot_gp::RobotNodeValue decode(std::uint8_t code) {
+        if (code > static_cast<std::uint8_t>(robot_gp::RobotCommand::ALIGN)) {
+            throw std::runtime_error("Invalid robot command code");
+        }
+        return {static_cast<robot_gp::RobotCommand>(code)};
+    }
+};
+
 #endif // ROBOT_GP_HPP
\ No newline at end of file